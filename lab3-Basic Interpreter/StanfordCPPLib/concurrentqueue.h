@@ -0,0 +1,553 @@
+/*
+ * File: concurrentqueue.h
+ * -----------------------
+ * This file exports two bounded first-in/first-out queues that can be
+ * shared between threads without a lock.  The <code>SPSCQueue</code>
+ * class allows one producing thread and one consuming thread; the
+ * <code>MPMCQueue</code> class allows any number of each.
+ */
+
+#ifndef _concurrentqueue_h
+#define _concurrentqueue_h
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+
+/*
+ * Constant: CACHE_LINE_SIZE
+ * -------------------------
+ * The assumed size of a cache line.  Indices written by different
+ * threads are kept this far apart so that they never share a line.
+ */
+
+const size_t CACHE_LINE_SIZE = 64;
+
+/*
+ * Class: SPSCQueue<ValueType>
+ * ---------------------------
+ * This class is a fixed-capacity ring buffer for passing values from
+ * exactly one producer thread to exactly one consumer thread.  Only the
+ * producer may call <code>enqueue</code> and <code>tryEnqueue</code>,
+ * and only the consumer may call <code>dequeue</code> and
+ * <code>tryDequeue</code>.  The other methods may be called from
+ * either thread but return a snapshot that may already be stale.
+ */
+
+template <typename ValueType>
+class SPSCQueue {
+
+public:
+
+/*
+ * Constructor: SPSCQueue
+ * Usage: SPSCQueue<ValueType> queue(capacity);
+ * --------------------------------------------
+ * Initializes a new empty queue that can hold at least
+ * <code>capacity</code> values.  The capacity is rounded up to a
+ * power of two.
+ */
+
+   explicit SPSCQueue(int capacity);
+
+/*
+ * Destructor: ~SPSCQueue
+ * ----------------------
+ * Frees the storage for the queue and any values still in it.  No
+ * other thread may be using the queue when it is destroyed.
+ */
+
+   ~SPSCQueue();
+
+/*
+ * Method: tryEnqueue
+ * Usage: if (queue.tryEnqueue(value)) ...
+ * ---------------------------------------
+ * Adds <code>value</code> to the end of the queue and returns
+ * <code>true</code>, or returns <code>false</code> at once if the
+ * queue is full.
+ */
+
+   bool tryEnqueue(ValueType value);
+
+/*
+ * Method: tryDequeue
+ * Usage: if (queue.tryDequeue(value)) ...
+ * ---------------------------------------
+ * Moves the first value in the queue into <code>value</code> and
+ * returns <code>true</code>, or returns <code>false</code> at once if
+ * the queue is empty.
+ */
+
+   bool tryDequeue(ValueType & value);
+
+/*
+ * Method: enqueue
+ * Usage: queue.enqueue(value);
+ * ----------------------------
+ * Adds <code>value</code> to the end of the queue, yielding the
+ * processor until there is room.
+ */
+
+   void enqueue(ValueType value);
+
+/*
+ * Method: dequeue
+ * Usage: ValueType first = queue.dequeue();
+ * -----------------------------------------
+ * Removes and returns the first value in the queue, yielding the
+ * processor until one arrives.
+ */
+
+   ValueType dequeue();
+
+/*
+ * Method: size
+ * Usage: int n = queue.size();
+ * ----------------------------
+ * Returns the number of values in the queue.
+ */
+
+   int size() const;
+
+/*
+ * Method: isEmpty
+ * Usage: if (queue.isEmpty()) ...
+ * -------------------------------
+ * Returns <code>true</code> if the queue contains no values.
+ */
+
+   bool isEmpty() const;
+
+/*
+ * Method: capacity
+ * Usage: int n = queue.capacity();
+ * --------------------------------
+ * Returns the number of values the queue can hold.
+ */
+
+   int capacity() const;
+
+/* Private section */
+
+/**********************************************************************/
+/* Note: Everything below this point in the file is logically part    */
+/* of the implementation and should not be of interest to clients.    */
+/**********************************************************************/
+
+/*
+ * Implementation notes: SPSCQueue data structure
+ * ----------------------------------------------
+ * The queue is a ring buffer of raw storage indexed by two counters
+ * that only ever increase; a counter is reduced to a slot with a mask.
+ * The producer alone writes tail and the consumer alone writes head,
+ * and each is published with a release store after the slot it covers
+ * has been filled or emptied.  Each thread also keeps a private copy of
+ * the other thread's counter and rereads the shared one only when the
+ * copy says the queue is full or empty, so in the steady state neither
+ * thread touches the other's cache line.  Because the class is aligned
+ * to a cache line, its size is rounded up to whole lines, and the last
+ * line cannot be shared with a neighbouring object.
+ */
+
+private:
+
+   ValueType *slots;                       /* Raw storage for the ring  */
+   size_t mask;                            /* Slot count minus one      */
+
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+   size_t cachedTail;                      /* Consumer's copy of tail   */
+
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+   size_t cachedHead;                      /* Producer's copy of head   */
+
+   bool tryEnqueueFrom(ValueType & value);
+
+/* Queues are not copied */
+
+   SPSCQueue(const SPSCQueue & src);
+   SPSCQueue & operator=(const SPSCQueue & src);
+
+};
+
+/*
+ * Class: MPMCQueue<ValueType>
+ * ---------------------------
+ * This class is a fixed-capacity queue that any number of threads may
+ * enqueue to and dequeue from at the same time.  Values enqueued by a
+ * single thread are dequeued in the order that thread enqueued them.
+ */
+
+template <typename ValueType>
+class MPMCQueue {
+
+public:
+
+/*
+ * Constructor: MPMCQueue
+ * Usage: MPMCQueue<ValueType> queue(capacity);
+ * --------------------------------------------
+ * Initializes a new empty queue that can hold at least
+ * <code>capacity</code> values.  The capacity is rounded up to a
+ * power of two.
+ */
+
+   explicit MPMCQueue(int capacity);
+
+/*
+ * Destructor: ~MPMCQueue
+ * ----------------------
+ * Frees the storage for the queue and any values still in it.  No
+ * other thread may be using the queue when it is destroyed.
+ */
+
+   ~MPMCQueue();
+
+/*
+ * Method: tryEnqueue
+ * Usage: if (queue.tryEnqueue(value)) ...
+ * ---------------------------------------
+ * Adds <code>value</code> to the end of the queue and returns
+ * <code>true</code>, or returns <code>false</code> at once if the
+ * queue is full.
+ */
+
+   bool tryEnqueue(ValueType value);
+
+/*
+ * Method: tryDequeue
+ * Usage: if (queue.tryDequeue(value)) ...
+ * ---------------------------------------
+ * Moves the first value in the queue into <code>value</code> and
+ * returns <code>true</code>, or returns <code>false</code> at once if
+ * the queue is empty.
+ */
+
+   bool tryDequeue(ValueType & value);
+
+/*
+ * Method: enqueue
+ * Usage: queue.enqueue(value);
+ * ----------------------------
+ * Adds <code>value</code> to the end of the queue, yielding the
+ * processor until there is room.
+ */
+
+   void enqueue(ValueType value);
+
+/*
+ * Method: dequeue
+ * Usage: ValueType first = queue.dequeue();
+ * -----------------------------------------
+ * Removes and returns the first value in the queue, yielding the
+ * processor until one arrives.
+ */
+
+   ValueType dequeue();
+
+/*
+ * Method: size
+ * Usage: int n = queue.size();
+ * ----------------------------
+ * Returns the approximate number of values in the queue.  The result
+ * may already be out of date when other threads are active.
+ */
+
+   int size() const;
+
+/*
+ * Method: isEmpty
+ * Usage: if (queue.isEmpty()) ...
+ * -------------------------------
+ * Returns <code>true</code> if the queue appeared empty when it was
+ * examined.
+ */
+
+   bool isEmpty() const;
+
+/*
+ * Method: capacity
+ * Usage: int n = queue.capacity();
+ * --------------------------------
+ * Returns the number of values the queue can hold.
+ */
+
+   int capacity() const;
+
+/* Private section */
+
+/**********************************************************************/
+/* Note: Everything below this point in the file is logically part    */
+/* of the implementation and should not be of interest to clients.    */
+/**********************************************************************/
+
+/*
+ * Implementation notes: MPMCQueue data structure
+ * ----------------------------------------------
+ * This is Dmitry Vyukov's bounded queue.  Each cell carries a sequence
+ * number alongside the storage for one value.  Cell i starts with
+ * sequence i.  A producer claims position pos by advancing enqueuePos
+ * with a compare-and-swap when the cell's sequence equals pos, stores
+ * the value, and publishes it by setting the sequence to pos + 1.  A
+ * consumer claims position pos from dequeuePos when the sequence equals
+ * pos + 1, moves the value out, and frees the cell for the next lap by
+ * setting the sequence to pos + capacity.  The difference between the
+ * sequence and the position tells a thread whether the cell is ready,
+ * whether the queue is full or empty, or whether another thread has
+ * already taken the position.  The two positions live on their own
+ * cache lines so that producers and consumers do not contend.
+ */
+
+private:
+
+   struct Cell {
+      std::atomic<size_t> sequence;        /* Lap-stamped cell state    */
+      alignas(ValueType) unsigned char storage[sizeof(ValueType)];
+   };
+
+   Cell *cells;                            /* The array of cells        */
+   size_t mask;                            /* Cell count minus one      */
+
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+
+   static ValueType *valueIn(Cell *cell) {
+      return reinterpret_cast<ValueType *>(cell->storage);
+   }
+
+   bool tryEnqueueFrom(ValueType & value);
+
+/* Queues are not copied */
+
+   MPMCQueue(const MPMCQueue & src);
+   MPMCQueue & operator=(const MPMCQueue & src);
+
+};
+
+extern void error(std::string msg);
+
+/*
+ * Implementation notes: concurrentQueueSize
+ * -----------------------------------------
+ * Returns the smallest power of two that is at least n, and at least 2.
+ */
+
+inline size_t concurrentQueueSize(int n) {
+   if (n <= 0) error("ConcurrentQueue: capacity must be positive");
+   size_t size = 2;
+   while (size < size_t(n)) {
+      size *= 2;
+   }
+   return size;
+}
+
+template <typename ValueType>
+SPSCQueue<ValueType>::SPSCQueue(int capacity) {
+   size_t n = concurrentQueueSize(capacity);
+   slots = static_cast<ValueType *>(::operator new(n * sizeof(ValueType)));
+   mask = n - 1;
+   head.store(0, std::memory_order_relaxed);
+   tail.store(0, std::memory_order_relaxed);
+   cachedHead = cachedTail = 0;
+}
+
+template <typename ValueType>
+SPSCQueue<ValueType>::~SPSCQueue() {
+   size_t end = tail.load(std::memory_order_relaxed);
+   for (size_t i = head.load(std::memory_order_relaxed); i != end; i++) {
+      slots[i & mask].~ValueType();
+   }
+   ::operator delete(slots);
+}
+
+template <typename ValueType>
+bool SPSCQueue<ValueType>::tryEnqueue(ValueType value) {
+   return tryEnqueueFrom(value);
+}
+
+template <typename ValueType>
+bool SPSCQueue<ValueType>::tryEnqueueFrom(ValueType & value) {
+   size_t t = tail.load(std::memory_order_relaxed);
+   if (t - cachedHead > mask) {
+      cachedHead = head.load(std::memory_order_acquire);
+      if (t - cachedHead > mask) return false;
+   }
+   new (slots + (t & mask)) ValueType(std::move(value));
+   tail.store(t + 1, std::memory_order_release);
+   return true;
+}
+
+template <typename ValueType>
+bool SPSCQueue<ValueType>::tryDequeue(ValueType & value) {
+   size_t h = head.load(std::memory_order_relaxed);
+   if (h == cachedTail) {
+      cachedTail = tail.load(std::memory_order_acquire);
+      if (h == cachedTail) return false;
+   }
+   ValueType *vp = slots + (h & mask);
+   value = std::move(*vp);
+   vp->~ValueType();
+   head.store(h + 1, std::memory_order_release);
+   return true;
+}
+
+template <typename ValueType>
+void SPSCQueue<ValueType>::enqueue(ValueType value) {
+   while (!tryEnqueueFrom(value)) {
+      std::this_thread::yield();
+   }
+}
+
+template <typename ValueType>
+ValueType SPSCQueue<ValueType>::dequeue() {
+   ValueType value;
+   while (!tryDequeue(value)) {
+      std::this_thread::yield();
+   }
+   return value;
+}
+
+template <typename ValueType>
+int SPSCQueue<ValueType>::size() const {
+   size_t h = head.load(std::memory_order_acquire);
+   size_t t = tail.load(std::memory_order_acquire);
+   return (t - h > mask + 1) ? 0 : int(t - h);
+}
+
+template <typename ValueType>
+bool SPSCQueue<ValueType>::isEmpty() const {
+   return size() == 0;
+}
+
+template <typename ValueType>
+int SPSCQueue<ValueType>::capacity() const {
+   return int(mask + 1);
+}
+
+template <typename ValueType>
+MPMCQueue<ValueType>::MPMCQueue(int capacity) {
+   size_t n = concurrentQueueSize(capacity);
+   cells = new Cell[n];
+   mask = n - 1;
+   for (size_t i = 0; i < n; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+   }
+   enqueuePos.store(0, std::memory_order_relaxed);
+   dequeuePos.store(0, std::memory_order_relaxed);
+}
+
+template <typename ValueType>
+MPMCQueue<ValueType>::~MPMCQueue() {
+   size_t end = enqueuePos.load(std::memory_order_relaxed);
+   for (size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        pos != end; pos++) {
+      valueIn(&cells[pos & mask])->~ValueType();
+   }
+   delete[] cells;
+}
+
+/*
+ * Implementation notes: tryEnqueueFrom and tryDequeue
+ * ---------------------------------------------------
+ * The signed difference between a cell's sequence and the position
+ * decides what happens.  Zero means the cell is ready and the thread
+ * tries to claim the position; a negative value means the queue is
+ * full (for a producer) or empty (for a consumer); a positive value
+ * means another thread claimed the position first, so the thread
+ * reloads the position and tries again.  In both classes the value is
+ * moved out of the argument of tryEnqueueFrom only once a slot has been
+ * claimed, so enqueue can keep retrying with the same value.
+ */
+
+template <typename ValueType>
+bool MPMCQueue<ValueType>::tryEnqueue(ValueType value) {
+   return tryEnqueueFrom(value);
+}
+
+template <typename ValueType>
+bool MPMCQueue<ValueType>::tryEnqueueFrom(ValueType & value) {
+   size_t pos = enqueuePos.load(std::memory_order_relaxed);
+   Cell *cell;
+   while (true) {
+      cell = &cells[pos & mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+      if (diff == 0) {
+         if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+            break;
+         }
+      } else if (diff < 0) {
+         return false;
+      } else {
+         pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+   }
+   new (cell->storage) ValueType(std::move(value));
+   cell->sequence.store(pos + 1, std::memory_order_release);
+   return true;
+}
+
+template <typename ValueType>
+bool MPMCQueue<ValueType>::tryDequeue(ValueType & value) {
+   size_t pos = dequeuePos.load(std::memory_order_relaxed);
+   Cell *cell;
+   while (true) {
+      cell = &cells[pos & mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+      if (diff == 0) {
+         if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+            break;
+         }
+      } else if (diff < 0) {
+         return false;
+      } else {
+         pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+   }
+   ValueType *vp = valueIn(cell);
+   value = std::move(*vp);
+   vp->~ValueType();
+   cell->sequence.store(pos + mask + 1, std::memory_order_release);
+   return true;
+}
+
+template <typename ValueType>
+void MPMCQueue<ValueType>::enqueue(ValueType value) {
+   while (!tryEnqueueFrom(value)) {
+      std::this_thread::yield();
+   }
+}
+
+template <typename ValueType>
+ValueType MPMCQueue<ValueType>::dequeue() {
+   ValueType value;
+   while (!tryDequeue(value)) {
+      std::this_thread::yield();
+   }
+   return value;
+}
+
+template <typename ValueType>
+int MPMCQueue<ValueType>::size() const {
+   size_t d = dequeuePos.load(std::memory_order_acquire);
+   size_t e = enqueuePos.load(std::memory_order_acquire);
+   return (e - d > mask + 1) ? 0 : int(e - d);
+}
+
+template <typename ValueType>
+bool MPMCQueue<ValueType>::isEmpty() const {
+   return size() == 0;
+}
+
+template <typename ValueType>
+int MPMCQueue<ValueType>::capacity() const {
+   return int(mask + 1);
+}
+
+#endif
@@ -260,10 +260,16 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag, ValueType> {
+   class iterator {
 
    public:
 
+      typedef std::input_iterator_tag iterator_category;
+      typedef ValueType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef ValueType *pointer;
+      typedef ValueType & reference;
+
       iterator(const Grid *gp, int index) {
          this->gp = gp;
          this->index = index;
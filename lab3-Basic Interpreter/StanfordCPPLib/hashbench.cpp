@@ -0,0 +1,193 @@
+/*
+ * File: hashbench.cpp
+ * -------------------
+ * This program measures the hashCode functions in hashmap.cpp for speed
+ * and for how evenly they spread typical keys over the buckets of a
+ * table.  It is not part of the library.  "make hashbench" builds it
+ * twice, once with the default functions and once with
+ * HASHCODE_USE_DJB2 defined, so the two families can be compared by
+ * running both programs on the same machine.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "hashmap.h"
+#include "hashset.h"
+using namespace std;
+
+#ifdef HASHCODE_USE_DJB2
+static const char *const VARIANT = "djb2";
+#else
+static const char *const VARIANT = "wyhash";
+#endif
+
+static const int BUCKET_BITS = 12;
+static const int NUM_BUCKETS = 1 << BUCKET_BITS;
+
+/*
+ * Function: secondsSince
+ * Usage: double t = secondsSince(start);
+ * --------------------------------------
+ * Returns the time in seconds that has passed since start.
+ */
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+   chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+   return elapsed.count();
+}
+
+/*
+ * Function: reportSpread
+ * Usage: reportSpread(label, hashes);
+ * -----------------------------------
+ * Drops the hash codes into NUM_BUCKETS buckets by their low bits, as
+ * HashMap does, and prints how many buckets are used, the fullest
+ * bucket, and the chi-squared statistic divided by its expected value.
+ * A good hash gives a ratio near 1.0; a ratio far above 1.0 means the
+ * keys cluster.
+ */
+
+static void reportSpread(const string & label, const vector<int> & hashes) {
+   vector<int> counts(NUM_BUCKETS, 0);
+   for (int hash : hashes) {
+      counts[hash & (NUM_BUCKETS - 1)]++;
+   }
+   double expected = double(hashes.size()) / NUM_BUCKETS;
+   double chi2 = 0;
+   int used = 0;
+   int fullest = 0;
+   for (int count : counts) {
+      if (count > 0) used++;
+      if (count > fullest) fullest = count;
+      chi2 += (count - expected) * (count - expected) / expected;
+   }
+   cout << left << setw(32) << label << right
+        << setw(6) << used << " of " << NUM_BUCKETS << " buckets,"
+        << " fullest " << setw(5) << fullest
+        << ", chi2 ratio " << fixed << setprecision(2)
+        << chi2 / (NUM_BUCKETS - 1) << endl;
+}
+
+/*
+ * Functions: makeIdentifiers, makeLineNumbers
+ * -------------------------------------------
+ * Build the key sets used by the tests: distinct random identifiers of
+ * 1 to 12 letters and digits, the kind of names a BASIC program uses,
+ * and the multiples of 10 that BASIC line numbers usually are.
+ */
+
+static vector<string> makeIdentifiers(int count) {
+   mt19937 rng(42);
+   const string chars = "abcdefghijklmnopqrstuvwxyz0123456789";
+   HashSet<string> seen;
+   vector<string> names;
+   while ((int) names.size() < count) {
+      string name(1, chars[rng() % 26]);
+      int length = 1 + rng() % 12;
+      while ((int) name.length() < length) {
+         name += chars[rng() % chars.length()];
+      }
+      if (!seen.contains(name)) {
+         seen.add(name);
+         names.push_back(name);
+      }
+   }
+   return names;
+}
+
+static vector<int> makeLineNumbers(int count) {
+   vector<int> numbers;
+   for (int i = 1; i <= count; i++) {
+      numbers.push_back(10 * i);
+   }
+   return numbers;
+}
+
+/*
+ * Throughput tests
+ * ----------------
+ * Each test sums the hash codes it computes into sink, which is printed
+ * at the end so that the compiler cannot drop the work.
+ */
+
+static unsigned sink = 0;
+
+static void timeLongString() {
+   string text(1 << 20, 'x');
+   for (size_t i = 0; i < text.length(); i++) {
+      text[i] = char('a' + i * 7 % 26);
+   }
+   const int rounds = 200;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < rounds; i++) {
+      text[i] ^= 1;
+      sink += hashCode(text);
+   }
+   double seconds = secondsSince(start);
+   cout << left << setw(32) << "1 MB string" << right << fixed
+        << setprecision(2) << setw(8)
+        << rounds * double(text.length()) / seconds / 1e9 << " GB/s" << endl;
+}
+
+static void timeIdentifiers(const vector<string> & names) {
+   const int rounds = 20;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < rounds; i++) {
+      for (const string & name : names) {
+         sink += hashCode(name);
+      }
+   }
+   double seconds = secondsSince(start);
+   cout << left << setw(32) << "short identifiers" << right << fixed
+        << setprecision(2) << setw(8)
+        << seconds * 1e9 / (rounds * double(names.size())) << " ns/key"
+        << endl;
+}
+
+static void timeHashMap(const vector<int> & numbers) {
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   HashMap<int,int> map;
+   for (int number : numbers) {
+      map.put(number, number);
+   }
+   for (int number : numbers) {
+      sink += map.get(number);
+   }
+   double seconds = secondsSince(start);
+   cout << left << setw(32) << "HashMap<int,int> line numbers" << right
+        << fixed << setprecision(2) << setw(8)
+        << seconds * 1e9 / (2 * double(numbers.size())) << " ns/op" << endl;
+}
+
+int main() {
+   const int numKeys = 100000;
+   vector<string> names = makeIdentifiers(numKeys);
+   vector<int> numbers = makeLineNumbers(numKeys);
+   cout << "hashCode variant: " << VARIANT << endl << endl;
+   cout << "Spread over the low " << BUCKET_BITS << " bits of "
+        << numKeys << " keys" << endl;
+   vector<int> hashes;
+   for (int number : numbers) hashes.push_back(hashCode(number));
+   reportSpread("multiples of 10", hashes);
+   hashes.clear();
+   for (int i = 0; i < numKeys; i++) hashes.push_back(hashCode(i << 8));
+   reportSpread("multiples of 256", hashes);
+   hashes.clear();
+   for (const string & name : names) hashes.push_back(hashCode(name));
+   reportSpread("random identifiers", hashes);
+   hashes.clear();
+   for (int i = 0; i < numKeys; i++) {
+      hashes.push_back(hashCode("x" + to_string(i)));
+   }
+   reportSpread("x0, x1, x2, ...", hashes);
+   cout << endl << "Throughput" << endl;
+   timeLongString();
+   timeIdentifiers(names);
+   timeHashMap(numbers);
+   cout << endl << "(checksum " << sink << ")" << endl;
+   return 0;
+}
@@ -5,14 +5,20 @@
  * with the HashMap class.
  */
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include "hashmap.h"
 using namespace std;
 
+const int HASH_MASK = unsigned(-1) >> 1;  /* All 1 bits except the sign     */
+
+#ifdef HASHCODE_USE_DJB2
+
 /*
- * Implementation notes: hashCode
- * ------------------------------
+ * Implementation notes: hashCode (HASHCODE_USE_DJB2)
+ * --------------------------------------------------
  * This function takes a string key and uses it to derive a hash code,
  * which is a nonnegative integer related to the key by a deterministic
  * function that distributes keys well across the space of integers.
@@ -20,11 +26,12 @@ using namespace std;
  * in random-number generators.  The specific algorithm used here is
  * called djb2 after the initials of its inventor, Daniel J. Bernstein,
  * Professor of Mathematics at the University of Illinois at Chicago.
+ * Integers hash to themselves.  These are the original StanfordCPPLib
+ * hash functions, and they give the same hash codes in every run.
  */
 
 const int HASH_SEED = 5381;               /* Starting point for first cycle */
 const int HASH_MULTIPLIER = 33;           /* Multiplier for each cycle      */
-const int HASH_MASK = unsigned(-1) >> 1;  /* All 1 bits except the sign     */
 
 int hashCode(const string & str) {
    unsigned hash = HASH_SEED;
@@ -40,9 +47,135 @@ int hashCode(int key) {
 }
 
 int hashCode(char key) {
-   return key;
+   return key & HASH_MASK;
 }
 
 int hashCode(long key) {
    return int(key) & HASH_MASK;
 }
+
+int hashCode(double key) {
+   if (key == 0) key = 0;
+   long long bits;
+   memcpy(&bits, &key, sizeof bits);
+   return int(bits ^ (bits >> 32)) & HASH_MASK;
+}
+
+#else
+
+/*
+ * Implementation notes: hashCode
+ * ------------------------------
+ * The hash functions follow the design of wyhash.  Strings are read
+ * eight bytes at a time, and each pair of words is combined by a 64x64
+ * to 128-bit multiplication whose two halves are folded together with
+ * exclusive-or, which mixes every input bit into every output bit.
+ * Integers go through the same multiplication, so nearby keys such as
+ * line numbers get unrelated hash codes.  Every hash starts from a seed
+ * chosen once per process from the clock and the address of a static,
+ * so an attacker cannot prepare keys that collide in advance.  As a
+ * result hash codes, and the iteration order of HashMap and HashSet,
+ * differ from run to run.  Defining HASHCODE_USE_DJB2 when building the
+ * library restores the original deterministic functions.
+ */
+
+typedef unsigned long long uint64;
+
+static const uint64 WY_P0 = 0xa0761d6478bd642fULL;
+static const uint64 WY_P1 = 0xe7037ed1a0b428dbULL;
+static const uint64 WY_P2 = 0x8ebc6af09c88c6e3ULL;
+static const uint64 WY_P3 = 0x589965cc75374cc3ULL;
+
+static uint64 mix(uint64 a, uint64 b) {
+#ifdef __SIZEOF_INT128__
+   unsigned __int128 product = (unsigned __int128) a * b;
+   return uint64(product) ^ uint64(product >> 64);
+#else
+   uint64 aLo = a & 0xffffffffULL, aHi = a >> 32;
+   uint64 bLo = b & 0xffffffffULL, bHi = b >> 32;
+   uint64 lo = aLo * bLo;
+   uint64 mid1 = aHi * bLo;
+   uint64 mid2 = aLo * bHi;
+   uint64 hi = aHi * bHi;
+   uint64 carry = ((lo >> 32) + (mid1 & 0xffffffffULL)
+                   + (mid2 & 0xffffffffULL)) >> 32;
+   lo += (mid1 << 32) + (mid2 << 32);
+   hi += (mid1 >> 32) + (mid2 >> 32) + carry;
+   return lo ^ hi;
+#endif
+}
+
+static uint64 read64(const char *p) {
+   uint64 word;
+   memcpy(&word, p, sizeof word);
+   return word;
+}
+
+static uint64 read32(const char *p) {
+   unsigned word;
+   memcpy(&word, p, sizeof word);
+   return word;
+}
+
+static uint64 processSeed() {
+   static const uint64 seed =
+      mix(uint64(chrono::steady_clock::now().time_since_epoch().count())
+          ^ WY_P0, uint64(size_t(&seed)) ^ WY_P1);
+   return seed;
+}
+
+static int finish(uint64 hash) {
+   return int(hash ^ (hash >> 32)) & HASH_MASK;
+}
+
+int hashCode(const string & str) {
+   const char *p = str.data();
+   size_t n = str.length();
+   uint64 seed = processSeed() ^ WY_P0;
+   uint64 a, b;
+   if (n <= 16) {
+      if (n >= 4) {
+         size_t mid = (n >> 3) << 2;
+         a = (read32(p) << 32) | read32(p + mid);
+         b = (read32(p + n - 4) << 32) | read32(p + n - 4 - mid);
+      } else if (n > 0) {
+         a = (uint64((unsigned char) p[0]) << 16)
+           | (uint64((unsigned char) p[n >> 1]) << 8)
+           | uint64((unsigned char) p[n - 1]);
+         b = 0;
+      } else {
+         a = b = 0;
+      }
+   } else {
+      size_t i = n;
+      while (i > 16) {
+         seed = mix(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+         p += 16;
+         i -= 16;
+      }
+      a = read64(p + i - 16);
+      b = read64(p + i - 8);
+   }
+   return finish(mix(WY_P1 ^ n, mix(a ^ WY_P1, b ^ seed)));
+}
+
+int hashCode(int key) {
+   return finish(mix(uint64(unsigned(key)) ^ processSeed() ^ WY_P2, WY_P3));
+}
+
+int hashCode(char key) {
+   return hashCode(int((unsigned char) key));
+}
+
+int hashCode(long key) {
+   return finish(mix(uint64(key) ^ processSeed() ^ WY_P2, WY_P3));
+}
+
+int hashCode(double key) {
+   if (key == 0) key = 0;
+   uint64 bits;
+   memcpy(&bits, &key, sizeof bits);
+   return finish(mix(bits ^ processSeed() ^ WY_P2, WY_P3));
+}
+
+#endif
@@ -10,6 +10,7 @@
 
 #include <cstdlib>
 #include <string>
+#include <utility>
 #include "foreach.h"
 #include "vector.h"
 
@@ -20,6 +21,10 @@
  * Returns a hash code for the specified key, which is always a
  * nonnegative integer.  This function is overloaded to support
  * all of the primitive types and the C++ <code>string</code> type.
+ * Hash codes are seeded once per process, so the same key can have a
+ * different hash code in another run of the program.  If the library
+ * is compiled with <code>HASHCODE_USE_DJB2</code> defined, the original
+ * unseeded functions are used instead and hash codes never change.
  */
 
 int hashCode(const std::string & key);
@@ -141,6 +146,16 @@ public:
 
    void clear();
 
+/*
+ * Method: reserve
+ * Usage: map.reserve(n);
+ * ----------------------
+ * Makes room for at least <code>n</code> entries, so that the map does
+ * not have to grow while they are added.
+ */
+
+   void reserve(int n);
+
 /*
  * Operator: []
  * Usage: map[key]
@@ -189,6 +204,8 @@ public:
  *   - Iteration using the range-based for statement and STL iterators
  *
  * The HashMap class makes no guarantees about the order of iteration.
+ * In particular, removing an entry during an iteration may move another
+ * entry to a slot that has already been visited.
  */
 
 /* Private section */
@@ -201,126 +218,157 @@ public:
 /*
  * Implementation notes:
  * ---------------------
- * The HashMap class is represented using a hash table that uses
- * bucket chaining to resolve collisions.
+ * The HashMap class is represented using an open-addressing hash table
+ * with Robin Hood linear probing.  The keys and values are stored
+ * inline in a single array of slots whose size is a power of two.
  */
 
 private:
 
 /* Constant definitions */
 
-   static const int INITIAL_BUCKET_COUNT = 101;
-   static const int MAX_LOAD_PERCENTAGE = 70;
+   static const int INITIAL_CAPACITY = 16;
+   static const int MAX_LOAD_PERCENTAGE = 80;
 
-/* Type definition for cells in the bucket chain */
+/* Type definition for the slots of the table */
 
-   struct Cell {
+   struct Slot {
       KeyType key;
       ValueType value;
-      Cell *next;
+      int hash;                    /* hashCode(key), kept for rehashing */
+      int distance;                /* Distance from home, -1 if empty   */
    };
 
 /* Instance variables */
 
-   Vector<Cell *> buckets;
-   int nBuckets;
-   int numEntries;
+   Slot *slots;                    /* The array of capacity slots       */
+   int capacity;                   /* Always a power of two             */
+   int shift;                      /* 32 minus log2 of capacity         */
+   int numEntries;                 /* The number of occupied slots      */
 
 /* Private methods */
 
 /*
- * Private method: createBuckets
- * Usage: createBuckets(nBuckets);
- * -------------------------------
- * Sets up the vector of buckets to have nBuckets entries, each NULL.
- * If asked to make empty vector, makes one bucket just to simplify
- * handling elsewhere.
+ * Private method: createSlots
+ * Usage: createSlots(capacity);
+ * -----------------------------
+ * Allocates an array of capacity empty slots, where capacity is a power
+ * of two no smaller than 2, and makes it the table.  Any previous array
+ * must already have been freed or saved by the caller.
  */
 
-   void createBuckets(int nBuckets) {
-      if (nBuckets == 0) nBuckets = 1;
-      buckets = Vector<Cell *>(nBuckets, NULL);
-      this->nBuckets = nBuckets;
+   void createSlots(int capacity) {
+      slots = new Slot[capacity];
+      for (int i = 0; i < capacity; i++) {
+         slots[i].distance = -1;
+      }
+      this->capacity = capacity;
+      shift = 32;
+      for (int n = capacity; n > 1; n >>= 1) {
+         shift--;
+      }
       numEntries = 0;
    }
 
 /*
- * Private method: deleteBuckets
- * Usage: deleteBuckets(buckets);
- * ------------------------------
- * Deletes all the cells in the linked lists contained in vector.
+ * Private method: homeSlot
+ * Usage: int index = homeSlot(hash);
+ * ----------------------------------
+ * Returns the slot at which a probe for the given hash code starts.
+ * The hash code is scrambled by Fibonacci hashing and the top bits are
+ * kept, so keys whose hash codes differ only in their high bits, such as
+ * multiples of the capacity, still spread across the table.
  */
 
-   void deleteBuckets(Vector <Cell *> & buckets) {
-      for (int i = 0; i < buckets.size(); i++) {
-         Cell *cp = buckets[i];
-         while (cp != NULL) {
-            Cell *np = cp->next;
-            delete cp;
-            cp = np;
-         }
-         buckets[i] = NULL;
-      }
+   int homeSlot(int hash) const {
+      return int((unsigned(hash) * 2654435769u) >> shift);
    }
 
 /*
- * Private method: expandAndRehash
- * Usage: expandAndRehash();
- * -------------------------
- * This method is used to increase the number of buckets in the map
- * and then rehashes all existing entries and adds them into new buckets.
- * This operation is used when the load factor (i.e. the number of cells
- * per bucket) has increased enough to warrant this O(N) operation to
- * enlarge and redistribute the entries.
+ * Private method: findSlot
+ * Usage: int index = findSlot(key, hash);
+ * ---------------------------------------
+ * Returns the index of the slot holding key, or -1 if key is absent.
+ * Robin Hood insertion keeps every run of slots ordered so that no
+ * entry is farther from its home than the entries before it, so the
+ * search stops at the first slot whose entry is nearer to its home than
+ * key would be at that point.
  */
 
-   void expandAndRehash() {
-      Vector<Cell *>oldBuckets = buckets;
-      createBuckets(oldBuckets.size() * 2 + 1);
-      for (int i = 0; i < oldBuckets.size(); i++) {
-         for (Cell *cp = oldBuckets[i]; cp != NULL; cp = cp->next) {
-            put(cp->key, cp->value);
-         }
+   int findSlot(const KeyType & key, int hash) const {
+      int mask = capacity - 1;
+      int index = homeSlot(hash);
+      for (int distance = 0; slots[index].distance >= distance; distance++) {
+         if (slots[index].hash == hash && slots[index].key == key) return index;
+         index = (index + 1) & mask;
       }
-      deleteBuckets(oldBuckets);
+      return -1;
    }
 
 /*
- * Private method: findCell
- * Usage: Cell *cp = findCell(bucket, key);
- *        Cell *cp = findCell(bucket, key, parent);
- * ------------------------------------------------
- * Finds a cell in the chain for the specified bucket that matches key.
- * If a match is found, the return value is a pointer to the cell containing
- * the matching key.  If no match is found, the function returns NULL.
- * If the optional third argument is supplied, it is filled in with the
- * cell preceding the matching cell to allow the client to splice out
- * the target cell in the delete call.  If parent is NULL, it indicates
- * that the cell is the first cell in the bucket chain.
+ * Private method: insertSlot
+ * Usage: int index = insertSlot(entry);
+ * -------------------------------------
+ * Inserts entry, whose key must not already be present, and returns the
+ * index where it ends up.  While probing, whenever entry is farther from
+ * its home than the occupant of the slot, the two change places and the
+ * insertion carries on with the displaced occupant.  The table must
+ * have at least one empty slot.
  */
 
-   Cell *findCell(int bucket, KeyType key) const {
-      Cell *dummy;
-      return findCell(bucket, key, dummy);
+   int insertSlot(Slot & entry) {
+      int mask = capacity - 1;
+      int index = homeSlot(entry.hash);
+      int placed = -1;
+      entry.distance = 0;
+      while (true) {
+         Slot & slot = slots[index];
+         if (slot.distance == -1) {
+            std::swap(slot, entry);
+            numEntries++;
+            return (placed == -1) ? index : placed;
+         }
+         if (slot.distance < entry.distance) {
+            std::swap(slot, entry);
+            if (placed == -1) placed = index;
+         }
+         index = (index + 1) & mask;
+         entry.distance++;
+      }
    }
 
-   Cell *findCell(int bucket, KeyType key, Cell * & parent) const {
-      parent = NULL;
-      Cell *cp = buckets.get(bucket);
-      while (cp != NULL && key != cp->key) {
-         parent = cp;
-         cp = cp->next;
+/*
+ * Private method: rehash
+ * Usage: rehash(newCapacity);
+ * ---------------------------
+ * Moves every entry into a new array of newCapacity slots.  The stored
+ * hash codes are reused, so hashCode is not called again.
+ */
+
+   void rehash(int newCapacity) {
+      Slot *oldSlots = slots;
+      int oldCapacity = capacity;
+      createSlots(newCapacity);
+      for (int i = 0; i < oldCapacity; i++) {
+         if (oldSlots[i].distance != -1) insertSlot(oldSlots[i]);
       }
-      return cp;
+      delete[] oldSlots;
    }
 
+/*
+ * Private method: deepCopy
+ * Usage: deepCopy(src);
+ * ---------------------
+ * Makes this map a copy of src.  Since both tables have the same
+ * capacity, the slots are copied in place without rehashing.
+ */
+
    void deepCopy(const HashMap & src) {
-      createBuckets(src.nBuckets);
-      for (int i = 0; i < src.nBuckets; i++) {
-         for (Cell *cp = src.buckets.get(i); cp != NULL; cp = cp->next) {
-            put(cp->key, cp->value);
-         }
+      createSlots(src.capacity);
+      for (int i = 0; i < capacity; i++) {
+         slots[i] = src.slots[i];
       }
+      numEntries = src.numEntries;
    }
 
 public:
@@ -344,7 +392,7 @@ public:
 
    HashMap & operator=(const HashMap & src) {
       if (this != &src) {
-         clear();
+         delete[] slots;
          deepCopy(src);
       }
       return *this;
@@ -359,16 +407,24 @@ public:
  * ----------------
  * The classes in the StanfordCPPLib collection implement input
  * iterators so that they work symmetrically with respect to the
- * corresponding STL classes.
+ * corresponding STL classes.  A HashMap iterator walks the slot
+ * array in memory order.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag,KeyType> {
+   class iterator {
+
+   public:
+
+      typedef std::input_iterator_tag iterator_category;
+      typedef KeyType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef KeyType *pointer;
+      typedef KeyType & reference;
 
    private:
 
       const HashMap *mp;           /* Pointer to the map           */
-      int bucket;                  /* Index of current bucket      */
-      Cell *cp;                    /* Current cell in bucket chain */
+      int index;                   /* Index of the current slot    */
 
    public:
 
@@ -378,28 +434,21 @@ public:
 
       iterator(const HashMap *mp, bool end) {
          this->mp = mp;
-         if (end) {
-            bucket = mp->nBuckets;
-            cp = NULL;
-         } else {
-            bucket = 0;
-            cp = mp->buckets.get(bucket);
-            while (cp == NULL && ++bucket < mp->nBuckets) {
-               cp = mp->buckets.get(bucket);
-            }
+         index = end ? mp->capacity : 0;
+         while (index < mp->capacity && mp->slots[index].distance == -1) {
+            index++;
          }
       }
 
       iterator(const iterator & it) {
          mp = it.mp;
-         bucket = it.bucket;
-         cp = it.cp;
+         index = it.index;
       }
 
       iterator & operator++() {
-         cp = cp->next;
-         while (cp == NULL && ++bucket < mp->nBuckets) {
-            cp = mp->buckets.get(bucket);
+         index++;
+         while (index < mp->capacity && mp->slots[index].distance == -1) {
+            index++;
          }
          return *this;
       }
@@ -411,7 +460,7 @@ public:
       }
 
       bool operator==(const iterator & rhs) {
-         return mp == rhs.mp && bucket == rhs.bucket && cp == rhs.cp;
+         return mp == rhs.mp && index == rhs.index;
       }
 
       bool operator!=(const iterator & rhs) {
@@ -419,11 +468,11 @@ public:
       }
 
       KeyType operator*() {
-         return cp->key;
+         return mp->slots[index].key;
       }
 
       KeyType *operator->() {
-         return &cp->key;
+         return &mp->slots[index].key;
       }
 
       friend class HashMap;
@@ -443,23 +492,26 @@ public:
 /*
  * Implementation notes: HashMap class
  * -----------------------------------
- * In this map implementation, the entries are stored in a hashtable.
- * The hashtable keeps a vector of "buckets", where each bucket is a
- * linked list of elements that share the same hash code (i.e. hash
- * collisions are resolved by chaining). The buckets are dynamically
- * allocated so that we can change the the number of buckets (rehash)
- * when the load factor becomes too high. The map should provide O(1)
+ * In this map implementation, the entries are stored inline in an
+ * open-addressing hash table that resolves collisions by linear probing
+ * with the Robin Hood rule: an entry being inserted takes the slot of
+ * any entry that is nearer to its own home slot, and that entry moves
+ * on instead.  This keeps probe lengths short and nearly equal, lets a
+ * failed search stop early, and allows a load factor of 80 percent.
+ * Removal shifts the following entries of the run back by one slot, so
+ * no tombstones are needed.  Lookups touch consecutive slots rather
+ * than following pointers, and the map provides O(1) expected
  * performance on the put/remove/get operations.
  */
 
 template <typename KeyType,typename ValueType>
 HashMap<KeyType,ValueType>::HashMap() {
-   createBuckets(INITIAL_BUCKET_COUNT);
+   createSlots(INITIAL_CAPACITY);
 }
 
 template <typename KeyType,typename ValueType>
 HashMap<KeyType,ValueType>::~HashMap() {
-   deleteBuckets(buckets);
+   delete[] slots;
 }
 
 template <typename KeyType,typename ValueType>
@@ -479,83 +531,92 @@ void HashMap<KeyType,ValueType>::put(KeyType key, ValueType value) {
 
 template <typename KeyType,typename ValueType>
 ValueType HashMap<KeyType,ValueType>::get(KeyType key) const {
-   Cell *cp = findCell(hashCode(key) % nBuckets, key);
-   if (cp == NULL) return ValueType();
-   return cp->value;
+   int index = findSlot(key, hashCode(key));
+   if (index == -1) return ValueType();
+   return slots[index].value;
 }
 
 template <typename KeyType,typename ValueType>
 bool HashMap<KeyType,ValueType>::containsKey(KeyType key) const {
-   return findCell(hashCode(key) % nBuckets, key) != NULL;
+   return findSlot(key, hashCode(key)) != -1;
 }
 
 template <typename KeyType,typename ValueType>
 void HashMap<KeyType,ValueType>::remove(KeyType key) {
-   int bucket = hashCode(key) % nBuckets;
-   Cell *parent;
-   Cell *cp = findCell(bucket, key, parent);
-   if (cp != NULL) {
-      if (parent == NULL) {
-         buckets[bucket] = cp->next;
-      } else {
-         parent->next = cp->next;
-      }
-      delete cp;
-      numEntries--;
+   int index = findSlot(key, hashCode(key));
+   if (index == -1) return;
+   int mask = capacity - 1;
+   int next = (index + 1) & mask;
+   while (slots[next].distance > 0) {
+      std::swap(slots[index], slots[next]);
+      slots[index].distance--;
+      index = next;
+      next = (next + 1) & mask;
    }
+   slots[index].key = KeyType();
+   slots[index].value = ValueType();
+   slots[index].distance = -1;
+   numEntries--;
 }
 
 template <typename KeyType,typename ValueType>
 void HashMap<KeyType,ValueType>::clear() {
-   deleteBuckets(buckets);
+   for (int i = 0; i < capacity; i++) {
+      if (slots[i].distance != -1) {
+         slots[i].key = KeyType();
+         slots[i].value = ValueType();
+         slots[i].distance = -1;
+      }
+   }
    numEntries = 0;
 }
 
+template <typename KeyType,typename ValueType>
+void HashMap<KeyType,ValueType>::reserve(int n) {
+   int newCapacity = capacity;
+   while ((long long) n * 100 > (long long) newCapacity * MAX_LOAD_PERCENTAGE) {
+      newCapacity *= 2;
+   }
+   if (newCapacity > capacity) rehash(newCapacity);
+}
+
 template <typename KeyType,typename ValueType>
 ValueType & HashMap<KeyType,ValueType>::operator[](KeyType key) {
-   int bucket = hashCode(key) % nBuckets;
-   Cell *cp = findCell(bucket, key);
-   if (cp == NULL) {
-      if (numEntries > MAX_LOAD_PERCENTAGE * nBuckets / 100.0) {
-         expandAndRehash();
-         bucket = hashCode(key) % nBuckets;
+   int hash = hashCode(key);
+   int index = findSlot(key, hash);
+   if (index == -1) {
+      if ((numEntries + 1) * 100 > capacity * MAX_LOAD_PERCENTAGE) {
+         rehash(capacity * 2);
       }
-      cp = new Cell;
-      cp->key = key;
-      cp->value = ValueType();
-      cp->next = buckets[bucket];
-      buckets[bucket] = cp;
-      numEntries++;
+      Slot entry;
+      entry.key = key;
+      entry.value = ValueType();
+      entry.hash = hash;
+      index = insertSlot(entry);
    }
-   return cp->value;
+   return slots[index].value;
 }
 
 template <typename KeyType,typename ValueType>
 void HashMap<KeyType,ValueType>::mapAll(void (*fn)(KeyType, ValueType)) const {
-   for (int i = 0 ; i < buckets.size(); i++) {
-      for (Cell *cp = buckets.get(i); cp != NULL; cp = cp->next) {
-         fn(cp->key, cp->value);
-      }
+   for (int i = 0; i < capacity; i++) {
+      if (slots[i].distance != -1) fn(slots[i].key, slots[i].value);
    }
 }
 
 template <typename KeyType,typename ValueType>
 void HashMap<KeyType,ValueType>::mapAll(void (*fn)(const KeyType &,
                                                    const ValueType &)) const {
-   for (int i = 0 ; i < buckets.size(); i++) {
-      for (Cell *cp = buckets.get(i); cp != NULL; cp = cp->next) {
-         fn(cp->key, cp->value);
-      }
+   for (int i = 0; i < capacity; i++) {
+      if (slots[i].distance != -1) fn(slots[i].key, slots[i].value);
    }
 }
 
 template <typename KeyType,typename ValueType>
 template <typename FunctorType>
 void HashMap<KeyType,ValueType>::mapAll(FunctorType fn) const {
-   for (int i = 0 ; i < buckets.size(); i++) {
-      for (Cell *cp = buckets.get(i); cp != NULL; cp = cp->next) {
-         fn(cp->key, cp->value);
-      }
+   for (int i = 0; i < capacity; i++) {
+      if (slots[i].distance != -1) fn(slots[i].key, slots[i].value);
    }
 }
 
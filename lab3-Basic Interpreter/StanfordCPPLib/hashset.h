@@ -118,6 +118,16 @@ public:
 
    void clear();
 
+/*
+ * Method: reserve
+ * Usage: set.reserve(n);
+ * ----------------------
+ * Makes room for at least <code>n</code> elements, so that the set does
+ * not have to grow while they are added.
+ */
+
+   void reserve(int n);
+
 /*
  * Operator: ==
  * Usage: set1 == set2
@@ -316,7 +326,15 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag,ValueType> {
+   class iterator {
+
+   public:
+
+      typedef std::input_iterator_tag iterator_category;
+      typedef ValueType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef ValueType *pointer;
+      typedef ValueType & reference;
 
    private:
 
@@ -378,7 +396,7 @@ extern void error(std::string msg);
 
 template <typename ValueType>
 HashSet<ValueType>::HashSet() {
-   /* Empty */
+   removeFlag = false;
 }
 
 template <typename ValueType>
@@ -421,8 +439,14 @@ void HashSet<ValueType>::clear() {
    map.clear();
 }
 
+template <typename ValueType>
+void HashSet<ValueType>::reserve(int n) {
+   map.reserve(n);
+}
+
 template <typename ValueType>
 bool HashSet<ValueType>::isSubsetOf(const HashSet & set2) const {
+   if (size() > set2.size()) return false;
    iterator it = begin();
    iterator end = this->end();
    while (it != end) {
@@ -436,12 +460,16 @@ bool HashSet<ValueType>::isSubsetOf(const HashSet & set2) const {
  * Implementation notes: set operators
  * -----------------------------------
  * The implementations for the set operators use iteration to walk
- * over the elements in one or both sets.
+ * over the elements in one or both sets.  Each result reserves room
+ * for the largest size it can reach before any element is added, so
+ * building it never rehashes, and an intersection probes the larger
+ * set with the elements of the smaller one.  Two sets of the same
+ * size are equal if one is a subset of the other.
  */
 
 template <typename ValueType>
 bool HashSet<ValueType>::operator==(const HashSet & set2) const {
-   return this->isSubsetOf(set2) && set2.isSubsetOf(*this);
+   return size() == set2.size() && this->isSubsetOf(set2);
 }
 
 template <typename ValueType>
@@ -451,7 +479,11 @@ bool HashSet<ValueType>::operator!=(const HashSet & set2) const {
 
 template <typename ValueType>
 HashSet<ValueType> HashSet<ValueType>::operator+(const HashSet & set2) const {
-   HashSet<ValueType> set = *this;
+   HashSet<ValueType> set;
+   set.reserve(size() + set2.size());
+   foreach (ValueType value in *this) {
+      set.add(value);
+   }
    foreach (ValueType value in set2) {
       set.add(value);
    }
@@ -468,9 +500,12 @@ HashSet<ValueType>::operator+(const ValueType & element) const {
 
 template <typename ValueType>
 HashSet<ValueType> HashSet<ValueType>::operator*(const HashSet & set2) const {
+   const HashSet & smaller = (size() <= set2.size()) ? *this : set2;
+   const HashSet & larger = (size() <= set2.size()) ? set2 : *this;
    HashSet<ValueType> set;
-   foreach (ValueType value in *this) {
-      if (set2.map.containsKey(value)) set.add(value);
+   set.reserve(smaller.size());
+   foreach (ValueType value in smaller) {
+      if (larger.map.containsKey(value)) set.add(value);
    }
    return set;
 }
@@ -478,6 +513,7 @@ HashSet<ValueType> HashSet<ValueType>::operator*(const HashSet & set2) const {
 template <typename ValueType>
 HashSet<ValueType> HashSet<ValueType>::operator-(const HashSet & set2) const {
    HashSet<ValueType> set;
+   set.reserve(size());
    foreach (ValueType value in *this) {
       if (!set2.map.containsKey(value)) set.add(value);
    }
@@ -494,6 +530,7 @@ HashSet<ValueType>::operator-(const ValueType & element) const {
 
 template <typename ValueType>
 HashSet<ValueType> & HashSet<ValueType>::operator+=(const HashSet & set2) {
+   reserve(size() + set2.size());
    foreach (ValueType value in set2) {
       this->add(value);
    }
@@ -8,7 +8,11 @@
  * 2) a Set<string> of other words.
  *
  * Typically the DAWG is used for a large list read from a file in binary
- * format.  The STL set is for words added piecemeal at runtime.
+ * format.  The STL set is for words added piecemeal at runtime.  A DAWG
+ * saved in the native format is mapped into memory and used in place.
+ * Alongside the edges, the lexicon keeps a bit mask of the letters in
+ * each run of sibling edges, so a lookup finds its child edge in one
+ * step instead of scanning the run.
  *
  * The DAWG idea comes from an article by Appel & Jacobson, CACM May 1988.
  * This lexicon implementation only has the code to load/search the DAWG.
@@ -26,9 +30,17 @@
 #include "error.h"
 #include "lexicon.h"
 #include "strlib.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 static void toLowerCaseInPlace(string & str);
+static void toLowerCase(string_view src, string & dst);
+static int countBits(uint32_t mask);
 
 /*
  * The DAWG is stored as an array of edges. Each edge is represented by
@@ -45,17 +57,52 @@ static void toLowerCaseInPlace(string & str);
 
 Lexicon::Lexicon() {
    edges = start = NULL;
-   numEdges = numDawgWords = 0;
+   childMasks = NULL;
+   numEdges = 0;
+   numDawgWords = 0;
+   mapping = NULL;
+   mappingLength = 0;
 }
 
 Lexicon::Lexicon(string filename) {
    edges = start = NULL;
-   numEdges = numDawgWords = 0;
+   childMasks = NULL;
+   numEdges = 0;
+   numDawgWords = 0;
+   mapping = NULL;
+   mappingLength = 0;
    addWordsFromFile(filename);
 }
 
 Lexicon::~Lexicon() {
-   if (edges) delete[] edges;
+   releaseDawg();
+}
+
+/*
+ * Implementation notes: releaseDawg
+ * ---------------------------------
+ * The edge and mask arrays either belong to the heap or lie inside a
+ * mapped native file, in which case the whole mapping is released.
+ */
+
+void Lexicon::releaseDawg() {
+#ifndef _WIN32
+   if (mapping != NULL) {
+      munmap(mapping, mappingLength);
+   } else {
+      delete[] edges;
+      delete[] childMasks;
+   }
+#else
+   delete[] edges;
+   delete[] childMasks;
+#endif
+   edges = start = NULL;
+   childMasks = NULL;
+   numEdges = 0;
+   numDawgWords = 0;
+   mapping = NULL;
+   mappingLength = 0;
 }
 
 /*
@@ -95,26 +142,236 @@ void Lexicon::readBinaryFile(string filename) {
                    || startIndex < 0 || numBytes < 0) {
       error("Improperly formed lexicon file " + filename);
    }
-   numEdges = numBytes/sizeof(Edge);
-   edges = new Edge[numEdges];
-   start = &edges[startIndex];
-   istr.read((char *)edges, numBytes);
+   long count = numBytes/sizeof(Edge);
+   if (startIndex >= count || count > 0x7FFFFFFF) {
+      error("Improperly formed lexicon file " + filename);
+   }
+   Edge *array = new Edge[count];
+   istr.read((char *)array, numBytes);
    if (istr.fail() && !istr.eof()) {
+      delete[] array;
       error("Improperly formed lexicon file " + filename);
    }
+   numEdges = count;
+   edges = array;
+   start = &edges[startIndex];
 
 #if defined(BYTE_ORDER) && BYTE_ORDER == LITTLE_ENDIAN
-   uint32_t *cur = (uint32_t *) edges;
+   uint32_t *cur = (uint32_t *) array;
    for (int i = 0; i < numEdges; i++, cur++) {
       *cur = my_ntohl(*cur);
    }
 #endif
 
    istr.close();
-   numDawgWords = countDawgWords(start);
+   numDawgWords = -1;
+   buildChildMasks(filename);
+}
+
+/*
+ * Implementation notes: runMask, buildChildMasks, checkChildMasks
+ * ---------------------------------------------------------------
+ * Bit n of childMasks[i] is set if the letter with ordinal n appears on
+ * edge i or on a later edge in the same run of siblings, which makes
+ * childMasks[i] the set of letters in the run when edge i starts one.
+ * Letters have ordinals 1 to 26, which leaves bit 0 free to serve as
+ * UNSORTED_RUN: runMask sets it when the letters from edge i to the end
+ * of the run are not in increasing order, and findEdgeForChar scans such
+ * a run instead of counting bits, so files with unsorted runs load and
+ * answer as they always did.  The masks are built in one backward pass,
+ * which also checks that every child index lies inside the array and
+ * that the last edge ends its run, so no walk along a run can leave the
+ * array.  readBinaryFile checks that the start edge lies inside the
+ * array before installing it.  A native file stores its masks, and
+ * checkChildMasks makes the same pass over them, rejecting the file
+ * unless every stored mask is the one the pass computes.  A file that
+ * fails either pass is released before the error is reported, so the
+ * lexicon is left empty rather than holding edges without masks.
+ */
+
+static const uint32_t UNSORTED_RUN = 1;
+
+bool Lexicon::runMask(int i, const uint32_t *masks, uint32_t & mask) const {
+   const Edge & edge = edges[i];
+   if (edge.children >= (unsigned long) numEdges) return false;
+   mask = uint32_t(1) << edge.letter;
+   if (!edge.lastEdge) {
+      if (i + 1 >= numEdges) return false;
+      if (edges[i + 1].letter <= edge.letter) mask |= UNSORTED_RUN;
+      mask |= masks[i + 1];
+   }
+   return true;
+}
+
+void Lexicon::buildChildMasks(string filename) {
+   uint32_t *masks = new uint32_t[numEdges];
+   for (int i = numEdges - 1; i >= 0; i--) {
+      if (!runMask(i, masks, masks[i])) {
+         delete[] masks;
+         releaseDawg();
+         error("Improperly formed lexicon file " + filename);
+      }
+   }
+   childMasks = masks;
+}
+
+bool Lexicon::checkChildMasks() const {
+   for (int i = numEdges - 1; i >= 0; i--) {
+      uint32_t mask;
+      if (!runMask(i, childMasks, mask) || mask != childMasks[i]) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/*
+ * Implementation notes: native file format
+ * ----------------------------------------
+ * A native lexicon file is a NativeHeader followed immediately by the
+ * edge array and then the child masks, both stored exactly as they sit
+ * in memory.  The header is a whole number of edges long, so the arrays
+ * that follow it are aligned wherever the file is mapped.  The
+ * byteOrder field holds NATIVE_BYTE_ORDER as the writing machine stored
+ * it; on a machine with the other byte order it reads back differently
+ * and the file is rejected.  The word count in the header saves counting the words
+ * when the file is read.
+ */
+
+struct NativeHeader {
+   char magic[4];             /* Always "LEXN"                     */
+   uint32_t byteOrder;        /* NATIVE_BYTE_ORDER in native order */
+   uint32_t version;          /* NATIVE_VERSION                    */
+   uint32_t startIndex;       /* Index of the first root edge      */
+   uint32_t numEdges;         /* Number of edges that follow       */
+   uint32_t numWords;         /* Number of words in the graph      */
+};
+
+static const char NATIVE_MAGIC[] = "LEXN";
+static const uint32_t NATIVE_BYTE_ORDER = 0x01020304;
+static const uint32_t NATIVE_VERSION = 2;
+
+void Lexicon::writeNativeFile(string filename) const {
+   if (!otherWords.isEmpty()) {
+      error("writeNativeFile: Lexicon contains words not in its DAWG");
+   }
+   if (start == NULL) {
+      error("writeNativeFile: Lexicon has no DAWG to write");
+   }
+   NativeHeader header;
+   memcpy(header.magic, NATIVE_MAGIC, 4);
+   header.byteOrder = NATIVE_BYTE_ORDER;
+   header.version = NATIVE_VERSION;
+   header.startIndex = start - edges;
+   header.numEdges = numEdges;
+   header.numWords = dawgWordCount();
+   ofstream ostr(filename.c_str(), IOS_OUT | IOS_BINARY | ios::trunc);
+   ostr.write((const char *) &header, sizeof header);
+   ostr.write((const char *) edges, numEdges * sizeof(Edge));
+   ostr.write((const char *) childMasks, numEdges * sizeof(uint32_t));
+   ostr.close();
+   if (ostr.fail()) error("writeNativeFile: Couldn't write " + filename);
+}
+
+/*
+ * Implementation notes: readNativeFile
+ * ------------------------------------
+ * On POSIX systems the file is mapped privately and read-only, and the
+ * edges are used where they lie, so nothing is copied or converted.
+ * Elsewhere the edges are read into a heap array with a single call.
+ * In both cases the header is checked against the length of the file
+ * before anything is used, and checkChildMasks then checks every edge
+ * and mask, so a damaged file is rejected instead of being read out of
+ * bounds.
+ */
+
+static bool isValidNativeHeader(const NativeHeader & header, size_t length,
+                                size_t edgeSize) {
+   if (memcmp(header.magic, NATIVE_MAGIC, 4) != 0) return false;
+   if (header.byteOrder != NATIVE_BYTE_ORDER) return false;
+   if (header.version != NATIVE_VERSION) return false;
+   if (header.numEdges == 0 || header.startIndex >= header.numEdges) {
+      return false;
+   }
+   if (header.numWords > 0x7FFFFFFF) return false;
+   size_t entrySize = edgeSize + sizeof(uint32_t);
+   return length == sizeof header + header.numEdges * entrySize;
+}
+
+void Lexicon::readNativeFile(string filename) {
+#ifndef _WIN32
+   int fd = open(filename.c_str(), O_RDONLY);
+   if (fd < 0) error("Couldn't open lexicon file " + filename);
+   struct stat sb;
+   if (fstat(fd, &sb) != 0 || size_t(sb.st_size) < sizeof(NativeHeader)) {
+      close(fd);
+      error("Improperly formed lexicon file " + filename);
+   }
+   size_t length = sb.st_size;
+   void *base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (base == MAP_FAILED) error("Couldn't map lexicon file " + filename);
+   const NativeHeader *header = (const NativeHeader *) base;
+   if (!isValidNativeHeader(*header, length, sizeof(Edge))) {
+      munmap(base, length);
+      error("Improperly formed lexicon file " + filename);
+   }
+   mapping = base;
+   mappingLength = length;
+   edges = (const Edge *) (header + 1);
+   childMasks = (const uint32_t *) (edges + header->numEdges);
+#else
+   ifstream istr(filename.c_str(), IOS_IN | IOS_BINARY);
+   if (istr.fail()) error("Couldn't open lexicon file " + filename);
+   istr.seekg(0, ios::end);
+   size_t length = istr.tellg();
+   istr.seekg(0, ios::beg);
+   NativeHeader storage;
+   const NativeHeader *header = &storage;
+   istr.read((char *) &storage, sizeof storage);
+   if (istr.fail() || !isValidNativeHeader(storage, length, sizeof(Edge))) {
+      error("Improperly formed lexicon file " + filename);
+   }
+   Edge *array = new Edge[storage.numEdges];
+   uint32_t *masks = new uint32_t[storage.numEdges];
+   istr.read((char *) array, storage.numEdges * sizeof(Edge));
+   istr.read((char *) masks, storage.numEdges * sizeof(uint32_t));
+   if (istr.fail()) {
+      delete[] array;
+      delete[] masks;
+      error("Improperly formed lexicon file " + filename);
+   }
+   edges = array;
+   childMasks = masks;
+#endif
+   numEdges = header->numEdges;
+   start = edges + header->startIndex;
+   numDawgWords = header->numWords;
+   if (!checkChildMasks()) {
+      releaseDawg();
+      error("Improperly formed lexicon file " + filename);
+   }
+}
+
+/*
+ * Implementation notes: dawgWordCount
+ * -----------------------------------
+ * Counting the words means visiting every path through the graph, so
+ * it is put off until the count is first needed and then remembered.
+ * Two threads that ask at once both count and store the same value.
+ */
+
+int Lexicon::dawgWordCount() const {
+   if (start == NULL) return 0;
+   int count = numDawgWords.load(memory_order_relaxed);
+   if (count < 0) {
+      count = countDawgWords(start);
+      numDawgWords.store(count, memory_order_relaxed);
+   }
+   return count;
 }
 
-int Lexicon::countDawgWords(Edge *ep) const {
+int Lexicon::countDawgWords(const Edge *ep) const {
    int count = 0;
    while (true) {
       if (ep->accept) count++;
@@ -139,11 +396,18 @@ void Lexicon::addWordsFromFile(string filename) {
       error("Couldn't open lexicon file " + filename);
    }
    istr.read(firstFour, 4);
-   if (strncmp(firstFour, expected, 4) == 0) {
-      if (otherWords.size() != 0) {
+   bool binary = strncmp(firstFour, expected, 4) == 0;
+   bool native = strncmp(firstFour, NATIVE_MAGIC, 4) == 0;
+   if (binary || native) {
+      if (otherWords.size() != 0 || start != NULL) {
          error("Binary files require an empty lexicon");
       }
-      readBinaryFile(filename);
+      istr.close();
+      if (native) {
+         readNativeFile(filename);
+      } else {
+         readBinaryFile(filename);
+      }
       return;
    }
    istr.seekg(0);
@@ -155,36 +419,43 @@ void Lexicon::addWordsFromFile(string filename) {
 }
 
 int Lexicon::size() const {
-   return numDawgWords + otherWords.size();
+   return dawgWordCount() + otherWords.size();
 }
 
 bool Lexicon::isEmpty() const {
-   return size() == 0;
+   return start == NULL && otherWords.isEmpty();
 }
 
 void Lexicon::clear() {
-   if (edges) delete[] edges;
-   edges = start = NULL;
-   numEdges = numDawgWords = 0;
+   releaseDawg();
    otherWords.clear();
 }
 
 /*
  * Implementation notes: findEdgeForChar
  * -------------------------------------
- * Iterate over sequence of children to find one that
- * matches the given char.  Returns NULL if we get to
- * last child without finding a match (thus no such
- * child edge exists).
+ * Finds the child edge in the run that starts at children that matches
+ * the given char, or returns NULL if there is none.  When the letters
+ * in a run are in increasing order, the matching edge comes after one
+ * edge for each letter in the run's mask that is smaller than ch, and
+ * counting those bits takes the place of scanning the run.  A run marked
+ * UNSORTED_RUN is scanned, and the mask guarantees the scan stops inside
+ * the run.  charToOrd folds the case of ch, and anything other than a
+ * letter is rejected before it is used as a shift count.
  */
 
-Lexicon::Edge *Lexicon::findEdgeForChar(Edge *children, char ch) const {
-   Edge *curEdge = children;
-   while (true) {
-      if (curEdge->letter == charToOrd(ch)) return curEdge;
-      if (curEdge->lastEdge) return NULL;
-      curEdge++;
+const Lexicon::Edge *Lexicon::findEdgeForChar(const Edge *children,
+                                              char ch) const {
+   unsigned int ord = charToOrd(ch);
+   if (ord < 1 || ord > 26) return NULL;
+   uint32_t bit = uint32_t(1) << ord;
+   uint32_t mask = childMasks[children - edges];
+   if ((mask & bit) == 0) return NULL;
+   if (mask & UNSORTED_RUN) {
+      while (children->letter != ord) children++;
+      return children;
    }
+   return children + countBits(mask & (bit - 1));
 }
 
 /*
@@ -194,9 +465,9 @@ Lexicon::Edge *Lexicon::findEdgeForChar(Edge *children, char ch) const {
  * If a path exists, return last edge; otherwise return NULL.
  */
 
-Lexicon::Edge *Lexicon::traceToLastEdge(const string & s) const {
-   if (!start) return NULL;
-   Edge *curEdge = findEdgeForChar(start, s[0]);
+const Lexicon::Edge *Lexicon::traceToLastEdge(string_view s) const {
+   if (!start || s.empty()) return NULL;
+   const Edge *curEdge = findEdgeForChar(start, s[0]);
    int len = (int) s.length();
    for (int i = 1; i < len; i++) {
       if (!curEdge || !curEdge->children) return NULL;
@@ -205,22 +476,103 @@ Lexicon::Edge *Lexicon::traceToLastEdge(const string & s) const {
    return curEdge;
 }
 
-bool Lexicon::containsPrefix(string prefix) const {
+/*
+ * Implementation notes: traceFrom
+ * -------------------------------
+ * Continues the trace of s from character index from, given that path
+ * already holds the edges matched for the characters before it.  Each
+ * edge matched is stored in path at the index of its character, so a
+ * later word with the same first letters can resume from there.  The
+ * return value is the number of leading characters of s that have a
+ * path through the DAWG.
+ */
+
+int Lexicon::traceFrom(string_view s, int from,
+                       Vector<const Edge *> & path) const {
+   int len = (int) s.length();
+   for (int i = from; i < len; i++) {
+      const Edge *children = start;
+      if (i > 0) {
+         int index = path[i - 1]->children;
+         children = (index == 0) ? NULL : &edges[index];
+      }
+      if (children == NULL) return i;
+      const Edge *edge = findEdgeForChar(children, s[i]);
+      if (edge == NULL) return i;
+      if (i < path.size()) {
+         path[i] = edge;
+      } else {
+         path.add(edge);
+      }
+   }
+   return len;
+}
+
+/*
+ * Implementation notes: contains and containsPrefix
+ * -------------------------------------------------
+ * The DAWG lookup folds case one character at a time, so a lowercase
+ * copy of the argument is made only when the words added at runtime
+ * also have to be searched.
+ */
+
+bool Lexicon::containsPrefix(string_view prefix) const {
    if (prefix.empty()) return true;
-   toLowerCaseInPlace(prefix);
    if (traceToLastEdge(prefix)) return true;
-   foreach (string word in otherWords) {
-      if (startsWith(word, prefix)) return true;
-      if (prefix < word) return false;
+   if (otherWords.isEmpty()) return false;
+   string lower;
+   toLowerCase(prefix, lower);
+   for (const string & word : otherWords) {
+      if (startsWith(word, lower)) return true;
+      if (lower < word) return false;
    }
    return false;
 }
 
-bool Lexicon::contains(string word) const {
-   toLowerCaseInPlace(word);
-   Edge *lastEdge = traceToLastEdge(word);
+bool Lexicon::contains(string_view word) const {
+   const Edge *lastEdge = traceToLastEdge(word);
    if (lastEdge && lastEdge->accept) return true;
-   return otherWords.contains(word);
+   if (otherWords.isEmpty()) return false;
+   string lower;
+   toLowerCase(word, lower);
+   return otherWords.contains(lower);
+}
+
+/*
+ * Implementation notes: containsMany
+ * ----------------------------------
+ * The path vector holds the edges matched for the previous word, of
+ * which the first matched characters have a path.  Each word starts
+ * its trace after the characters it shares with those, and the one
+ * lowercase buffer is reused for every word that has to be looked up
+ * among the words added at runtime.
+ */
+
+Vector<bool> Lexicon::containsMany(const Vector<string> & words) const {
+   Vector<bool> results;
+   results.reserve(words.size());
+   Vector<const Edge *> path;
+   string lower;
+   string_view previous;
+   int matched = 0;
+   for (const string & word : words) {
+      int len = (int) word.length();
+      int common = 0;
+      int limit = min(matched, len);
+      while (common < limit
+             && charToOrd(word[common]) == charToOrd(previous[common])) {
+         common++;
+      }
+      matched = traceFrom(word, common, path);
+      bool found = len > 0 && matched == len && path[len - 1]->accept;
+      if (!found && !otherWords.isEmpty()) {
+         toLowerCase(word, lower);
+         found = otherWords.contains(lower);
+      }
+      results.add(found);
+      previous = word;
+   }
+   return results;
 }
 
 void Lexicon::add(string word) {
@@ -230,29 +582,118 @@ void Lexicon::add(string word) {
    }
 }
 
+/*
+ * Implementation notes: mapPrefix
+ * -------------------------------
+ * The words under the prefix are produced by a depth-first walk of the
+ * DAWG that builds each word in a single buffer.  The words added at
+ * runtime that begin with the prefix form one run in the sorted set, so
+ * they are merged into the walk as it goes: before each DAWG word is
+ * visited, every pending set word that sorts before it is visited.
+ */
+
+struct Lexicon::PrefixWalk {
+   string buffer;                          /* The word being built   */
+   Set<string>::iterator next;             /* Next set word to visit */
+   Set<string>::iterator end;
+   size_t prefixLength;
+   WordVisitor visit;
+   void *data;
+
+   void visitSetWordsBefore(const string *limit) {
+      while (next != end && (limit == NULL || *next < *limit)) {
+         const string & word = *next;
+         if (word.compare(0, prefixLength, buffer, 0, prefixLength) != 0) {
+            next = end;
+            return;
+         }
+         ++next;
+         visit(word, data);
+      }
+   }
+};
+
+void Lexicon::walkEdges(const Edge *ep, PrefixWalk & walk) const {
+   while (true) {
+      walk.buffer.push_back(ordToChar(ep->letter));
+      if (ep->accept) {
+         walk.visitSetWordsBefore(&walk.buffer);
+         walk.visit(walk.buffer, walk.data);
+      }
+      if (ep->children != 0) walkEdges(&edges[ep->children], walk);
+      walk.buffer.pop_back();
+      if (ep->lastEdge) break;
+      ep++;
+   }
+}
+
+void Lexicon::walkPrefix(string_view prefix, WordVisitor visit,
+                         void *data) const {
+   PrefixWalk walk;
+   toLowerCase(prefix, walk.buffer);
+   walk.prefixLength = walk.buffer.length();
+   walk.next = otherWords.begin();
+   walk.end = otherWords.end();
+   walk.visit = visit;
+   walk.data = data;
+   while (walk.next != walk.end && *walk.next < walk.buffer) {
+      ++walk.next;
+   }
+   const Edge *children = NULL;
+   if (prefix.empty()) {
+      children = start;
+   } else {
+      const Edge *lastEdge = traceToLastEdge(prefix);
+      if (lastEdge != NULL) {
+         if (lastEdge->accept) {
+            walk.visitSetWordsBefore(&walk.buffer);
+            visit(walk.buffer, data);
+         }
+         if (lastEdge->children != 0) children = &edges[lastEdge->children];
+      }
+   }
+   if (children != NULL) walkEdges(children, walk);
+   walk.visitSetWordsBefore(NULL);
+}
+
 Lexicon::Lexicon(const Lexicon & src) {
+   mapping = NULL;
+   mappingLength = 0;
    deepCopy(src);
 }
 
 Lexicon & Lexicon::operator=(const Lexicon & src) {
    if (this != &src) {
-      if (edges != NULL) delete[] edges;
+      releaseDawg();
       deepCopy(src);
    }
    return *this;
 }
 
+/*
+ * Implementation notes: deepCopy
+ * ------------------------------
+ * A copy always holds its edges on the heap, even when the source
+ * lexicon maps them from a native file.
+ */
+
 void Lexicon::deepCopy(const Lexicon & src) {
    if (src.edges == NULL) {
       edges = NULL;
       start = NULL;
+      childMasks = NULL;
+      numEdges = 0;
    } else {
       numEdges = src.numEdges;
-      edges = new Edge[src.numEdges];
-      memcpy(edges, src.edges, sizeof(Edge)*src.numEdges);
+      Edge *array = new Edge[src.numEdges];
+      memcpy(array, src.edges, sizeof(Edge)*src.numEdges);
+      uint32_t *masks = new uint32_t[src.numEdges];
+      memcpy(masks, src.childMasks, sizeof(uint32_t)*src.numEdges);
+      edges = array;
+      childMasks = masks;
       start = edges + (src.start - src.edges);
    }
-   numDawgWords = src.numDawgWords;
+   numDawgWords = src.numDawgWords.load(memory_order_relaxed);
    otherWords = src.otherWords;
 }
 
@@ -289,7 +730,7 @@ void Lexicon::iterator::advanceToNextWordInDawg() {
 }
 
 void Lexicon::iterator::advanceToNextEdge() {
-   Edge *ep = edgePtr;
+   const Edge *ep = edgePtr;
    if (ep->children == 0) {
       while (ep != NULL && ep->lastEdge) {
          if (stack.isEmpty()) {
@@ -314,3 +755,26 @@ static void toLowerCaseInPlace(string & str) {
       str[i] = tolower(str[i]);
    }
 }
+
+/*
+ * Implementation notes: toLowerCase
+ * ---------------------------------
+ * Stores a lowercase copy of src in dst, reusing the storage dst
+ * already has.
+ */
+
+static void toLowerCase(string_view src, string & dst) {
+   dst.assign(src.data(), src.length());
+   toLowerCaseInPlace(dst);
+}
+
+static int countBits(uint32_t mask) {
+#if defined(__GNUC__)
+   return __builtin_popcount(mask);
+#else
+   mask = mask - ((mask >> 1) & 0x55555555);
+   mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+   mask = (mask + (mask >> 4)) & 0x0F0F0F0F;
+   return (mask * 0x01010101) >> 24;
+#endif
+}
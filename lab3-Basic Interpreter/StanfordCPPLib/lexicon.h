@@ -8,10 +8,14 @@
 #ifndef _lexicon_h
 #define _lexicon_h
 
+#include <atomic>
 #include <string>
+#include <string_view>
+#include <stdint.h>
 #include "foreach.h"
 #include "set.h"
 #include "stack.h"
+#include "vector.h"
 
 /*
  * Class: Lexicon
@@ -23,6 +27,9 @@
  * It is therefore similar to a set of strings, but with a more
  * space-efficient internal representation.  The <code>Lexicon</code>
  * class supports efficient lookup operations for words and prefixes.
+ * Once a lexicon has been filled, any number of threads may call its
+ * <code>const</code> methods at the same time, provided no thread
+ * changes it while they do.
  *
  * <p>As an example of the use of the <code>Lexicon</code> class, the
  * following program lists all the two-letter words in the lexicon
@@ -54,8 +61,9 @@ public:
  * -----------------------------
  * Initializes a new lexicon.  The default constructor creates an empty
  * lexicon.  The second form reads in the contents of the lexicon from
- * the specified data file.  The data file must be in one of two formats:
- * (1) a space-efficient precompiled binary format or (2) a text file
+ * the specified data file.  The data file must be in one of three formats:
+ * (1) a space-efficient precompiled binary format, (2) the native
+ * format written by <code>writeNativeFile</code>, or (3) a text file
  * containing one word per line.  The Stanford library distribution
  * includes a binary lexicon file named <code>English.dat</code>
  * containing a list of words in English.  The standard code pattern
@@ -122,6 +130,22 @@ public:
 
    void addWordsFromFile(std::string filename);
 
+/*
+ * Method: writeNativeFile
+ * Usage: lex.writeNativeFile(filename);
+ * -------------------------------------
+ * Writes the lexicon to a file in the native format, which stores the
+ * word graph exactly as it is laid out in memory on this machine along
+ * with the number of words.  Reading a native file maps it into memory
+ * instead of copying it, so even a large lexicon is ready at once, and
+ * processes that read the same file share its pages.  Native files can
+ * be read only on machines with the same byte order.  Only a lexicon
+ * read from a binary or native file can be written, and only if no
+ * words have been added to it since.
+ */
+
+   void writeNativeFile(std::string filename) const;
+
 /*
  * Method: contains
  * Usage: if (lex.contains(word)) ...
@@ -131,7 +155,20 @@ public:
  * ignored, so "Zoo" is the same as "ZOO" or "zoo".
  */
 
-   bool contains(std::string word) const;
+   bool contains(std::string_view word) const;
+
+/*
+ * Method: containsMany
+ * Usage: Vector<bool> found = lex.containsMany(words);
+ * ----------------------------------------------------
+ * Returns a vector whose element <code>i</code> is <code>true</code> if
+ * <code>words[i]</code> is contained in the lexicon.  The answers are
+ * the same as those from calling <code>contains</code> on each word,
+ * but each lookup resumes from the letters the word shares with the
+ * one before it, so the batch is fastest when the words are sorted.
+ */
+
+   Vector<bool> containsMany(const Vector<std::string> & words) const;
 
 /*
  * Method: containsPrefix
@@ -142,7 +179,21 @@ public:
  * so that "MO" is a prefix of "monkey" or "Monday".
  */
 
-   bool containsPrefix(std::string prefix) const;
+   bool containsPrefix(std::string_view prefix) const;
+
+/*
+ * Method: mapPrefix
+ * Usage: lexicon.mapPrefix(prefix, fn);
+ * -------------------------------------
+ * Calls <code>fn</code> in alphabetical order on each word in the
+ * lexicon that begins with <code>prefix</code>, ignoring case.  Each
+ * word is passed as a <code>std::string_view</code> that is valid only
+ * until <code>fn</code> returns, so no string is built for a word the
+ * caller does not keep.
+ */
+
+   template <typename FunctorType>
+   void mapPrefix(std::string_view prefix, FunctorType fn) const;
 
 /*
  * Method: mapAll
@@ -202,8 +253,12 @@ private:
    };
 #pragma pack()
 
-   Edge *edges, *start;
-   int numEdges, numDawgWords;
+   const Edge *edges, *start;
+   int numEdges;
+   const uint32_t *childMasks;               /* Letters in each run    */
+   mutable std::atomic<int> numDawgWords;    /* -1 until first counted */
+   void *mapping;                            /* Mapped file, or NULL   */
+   size_t mappingLength;                     /* Its length in bytes    */
    Set<std::string> otherWords;
 
 public:
@@ -231,15 +286,24 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag,std::string> {
+   class iterator {
+
+   public:
+
+      typedef std::input_iterator_tag iterator_category;
+      typedef std::string value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef std::string *pointer;
+      typedef std::string & reference;
+
    private:
       const Lexicon *lp;
       int index;
       std::string currentDawgPrefix;
       std::string currentSetWord;
       std::string tmpWord;
-      Edge *edgePtr;
-      Stack<Edge *> stack;
+      const Edge *edgePtr;
+      Stack<const Edge *> stack;
       Set<std::string>::iterator setIterator;
       Set<std::string>::iterator setEnd;
 
@@ -337,14 +401,33 @@ public:
 
 private:
 
-   Edge *findEdgeForChar(Edge *children, char ch) const;
-   Edge *traceToLastEdge(const std::string & s) const;
+   typedef void (*WordVisitor)(std::string_view word, void *data);
+   struct PrefixWalk;
+
+   const Edge *findEdgeForChar(const Edge *children, char ch) const;
+   const Edge *traceToLastEdge(std::string_view s) const;
+   int traceFrom(std::string_view s, int from,
+                 Vector<const Edge *> & path) const;
    void readBinaryFile(std::string filename);
+   void readNativeFile(std::string filename);
+   void buildChildMasks(std::string filename);
+   bool runMask(int i, const uint32_t *masks, uint32_t & mask) const;
+   bool checkChildMasks() const;
+   void releaseDawg();
    void deepCopy(const Lexicon & src);
-   int countDawgWords(Edge *start) const;
+   int dawgWordCount() const;
+   int countDawgWords(const Edge *start) const;
+   void walkEdges(const Edge *ep, PrefixWalk & walk) const;
+   void walkPrefix(std::string_view prefix, WordVisitor visit,
+                   void *data) const;
+
+   template <typename FunctorType>
+   static void visitWord(std::string_view word, void *data) {
+      (*static_cast<FunctorType *>(data))(word);
+   }
 
    unsigned int charToOrd(char ch) const {
-      return ((unsigned int)(tolower(ch) - 'a' + 1));
+      return ((unsigned int)(tolower((unsigned char) ch) - 'a' + 1));
    }
 
    char ordToChar(unsigned int ord) const {
@@ -360,4 +443,9 @@ void Lexicon::mapAll(FunctorType fn) const {
    }
 }
 
+template <typename FunctorType>
+void Lexicon::mapPrefix(std::string_view prefix, FunctorType fn) const {
+   walkPrefix(prefix, visitWord<FunctorType>, &fn);
+}
+
 #endif
@@ -9,8 +9,116 @@
 #define _map_h
 
 #include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include "error.h"
 #include "foreach.h"
-#include "stack.h"
+#include "strlib.h"
+
+/*
+ * Class: MapComparator<KeyType>
+ * -----------------------------
+ * This class is the default comparison functor for <code>Map</code>
+ * and <code>Set</code>.  A default-constructed comparator orders keys
+ * using <code>std::less</code>, which the compiler inlines.  Any other
+ * functor passed to the constructor is stored behind a virtual
+ * interface, so that maps and sets can carry their own comparators
+ * without naming them in the type.  The <code>Graph</code> class
+ * relies on this to order its nodes and arcs by name.
+ */
+
+template <typename KeyType>
+class MapComparator {
+
+public:
+
+   MapComparator() {
+      cmpp = NULL;
+   }
+
+   MapComparator(std::less<KeyType>) {
+      cmpp = NULL;
+   }
+
+   template <typename FunctorType,
+             typename = typename std::enable_if<
+                !std::is_same<typename std::decay<FunctorType>::type,
+                              MapComparator>::value>::type>
+   MapComparator(FunctorType fn) {
+      cmpp = new TemplateComparator<FunctorType>(fn);
+   }
+
+   MapComparator(const MapComparator & src) {
+      cmpp = (src.cmpp == NULL) ? NULL : src.cmpp->clone();
+   }
+
+   MapComparator(MapComparator && src) {
+      cmpp = src.cmpp;
+      src.cmpp = NULL;
+   }
+
+   ~MapComparator() {
+      delete cmpp;
+   }
+
+   MapComparator & operator=(const MapComparator & src) {
+      if (this != &src) {
+         Comparator *copy = (src.cmpp == NULL) ? NULL : src.cmpp->clone();
+         delete cmpp;
+         cmpp = copy;
+      }
+      return *this;
+   }
+
+   MapComparator & operator=(MapComparator && src) {
+      std::swap(cmpp, src.cmpp);
+      return *this;
+   }
+
+   bool operator()(const KeyType & k1, const KeyType & k2) const {
+      if (cmpp == NULL) return std::less<KeyType>()(k1, k2);
+      return cmpp->lessThan(k1, k2);
+   }
+
+   bool usesDefaultOrder() const {
+      return cmpp == NULL;
+   }
+
+private:
+
+   class Comparator {
+   public:
+      virtual ~Comparator() { }
+      virtual bool lessThan(const KeyType & k1, const KeyType & k2) = 0;
+      virtual Comparator *clone() = 0;
+   };
+
+   template <typename FunctorType>
+   class TemplateComparator : public Comparator {
+   public:
+      TemplateComparator(FunctorType fn) : fn(fn) {
+         /* Empty */
+      }
+
+      virtual bool lessThan(const KeyType & k1, const KeyType & k2) {
+         return fn(k1, k2);
+      }
+
+      virtual Comparator *clone() {
+         return new TemplateComparator<FunctorType>(fn);
+      }
+
+   private:
+      FunctorType fn;
+   };
+
+   Comparator *cmpp;               /* NULL when std::less is used     */
+
+};
 
 /*
  * Class: Map<KeyType,ValueType>
@@ -18,10 +126,14 @@
  * This class maintains an association between <b><i>keys</i></b> and
  * <b><i>values</i></b>.  The types used for keys and values are
  * specified using templates, which makes it possible to use
- * this structure with any data type.
+ * this structure with any data type.  An optional third template
+ * parameter names the comparison functor; when it is a concrete type
+ * such as <code>std::greater&lt;int&gt;</code>, every comparison is
+ * a direct, inlinable call.
  */
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType,
+          typename CompareType = MapComparator<KeyType> >
 class Map {
 
 public:
@@ -36,6 +148,21 @@ public:
 
    Map();
 
+/*
+ * Constructor: Map
+ * Usage: Map<KeyType,ValueType> map(first, last);
+ * -----------------------------------------------
+ * Initializes a map from the range of key-value pairs between the
+ * iterators <code>first</code> and <code>last</code>, such as those of
+ * a <code>std::map</code> or a sorted vector of <code>std::pair</code>.
+ * If the keys arrive in strictly ascending order, the balanced tree
+ * is built directly in linear time.  Otherwise the pairs are added one
+ * at a time, and a later value replaces an earlier one for the same key.
+ */
+
+   template <typename IteratorType>
+   Map(IteratorType first, IteratorType last);
+
 /*
  * Destructor: ~Map
  * ----------------
@@ -178,6 +305,13 @@ public:
  * The map class is represented using a binary search tree.  The
  * specific implementation used here is the classic AVL algorithm
  * developed by Georgii Adel'son-Vel'skii and Evgenii Landis in 1962.
+ * The nodes are carved out of slabs owned by the map, so adding an
+ * entry ordinarily costs no call to the global allocator, nodes that
+ * are added together sit together in memory, and clearing the map
+ * releases a handful of slabs rather than every node in turn.
+ *
+ * Every node also points to its parent, which lets the iterator step
+ * to the in-order successor without keeping a stack of the path.
  */
 
 private:
@@ -188,6 +322,9 @@ private:
    static const int BST_IN_BALANCE = 0;
    static const int BST_RIGHT_HEAVY = +1;
 
+   static const int MIN_SLAB_NODES = 8;
+   static const int MAX_SLAB_NODES = 1024;
+
 /* Type definition for nodes in the binary search tree */
 
    struct BSTNode {
@@ -195,106 +332,150 @@ private:
       ValueType value;         /* The corresponding value             */
       BSTNode *left;           /* Subtree containing all smaller keys */
       BSTNode *right;          /* Subtree containing all larger keys  */
+      BSTNode *parent;         /* Parent node, or NULL at the root    */
       int bf;                  /* AVL balance factor                  */
    };
 
 /*
- * Implementation notes: Comparator
- * --------------------------------
- * The Comparator class encapsulates a functor that compares two values
- * of KeyType.  In contrast to the classes in the STL, all of which embed
- * the comparator in the type, the Map class and its derivatives pass an
- * optional Comparator value.  While this strategy results in a more
- * complex implementation, it has the advantage of allowing maps and sets
- * to carry their own comparators without forcing the client to include
- * the comparator in the template declaration.  This simplification is
- * particularly important for the Graph class.
- *
- * The allocation is required in the TemplateComparator class because
- * the type std::binary_function has subclasses but does not define a
- * virtual destructor.
+ * Implementation notes: node pool
+ * -------------------------------
+ * Each slab is a single block from ::operator new holding a NodeSlab
+ * header followed by raw storage for capacity nodes.  Nodes are handed
+ * out from the newest slab in address order; a removed node is
+ * destroyed and its storage pushed on a free list, which is reused
+ * before any new storage.  Slabs start at MIN_SLAB_NODES and double
+ * up to MAX_SLAB_NODES, so small maps stay small.  Every slab is
+ * returned at once by releasePool.
  */
 
-   class Comparator {
-   public:
-      virtual ~Comparator() { }
-      virtual bool lessThan(const KeyType & k1, const KeyType & k2) = 0;
-      virtual Comparator *clone() = 0;
+   struct NodeSlab {
+      NodeSlab *next;          /* The previously allocated slab       */
+      int capacity;            /* Number of nodes the slab can hold   */
+      int used;                /* Number of nodes handed out so far   */
    };
 
-   template <typename CompareType>
-   class TemplateComparator : public Comparator {
-   public:
-      TemplateComparator(CompareType cmp) {
-         this->cmp = new CompareType(cmp);
-      }
+   struct FreeNode {
+      FreeNode *next;          /* Next piece of free node storage     */
+   };
 
-      virtual bool lessThan(const KeyType & k1, const KeyType & k2) {
-         return (*cmp)(k1, k2);
-      }
+/* Instance variables */
 
-      virtual Comparator *clone() {
-         return new TemplateComparator<CompareType>(*cmp);
-      }
+   BSTNode *root;                  /* Pointer to the root of the tree */
+   int nodeCount;                  /* Number of entries in the map    */
+   mutable CompareType cmp;        /* The key comparison functor      */
+   NodeSlab *slabs;                /* Newest slab, linked to older    */
+   FreeNode *freeList;             /* Storage of removed nodes        */
 
-   private:
-      CompareType *cmp;
-   };
+/* Private methods */
 
-   Comparator & getComparator() const {
-      return *cmpp;
+   static size_t slabHeaderSize() {
+      size_t align = alignof(BSTNode);
+      return (sizeof(NodeSlab) + align - 1) / align * align;
    }
 
-/* Instance variables */
+   void initPool() {
+      slabs = NULL;
+      freeList = NULL;
+   }
 
-   BSTNode *root;                  /* Pointer to the root of the tree */
-   int nodeCount;                  /* Number of entries in the map    */
-   Comparator *cmpp;               /* Pointer to the comparator       */
+   void allocateSlab(int capacity) {
+      void *block = ::operator new(slabHeaderSize()
+                                   + capacity * sizeof(BSTNode));
+      NodeSlab *slab = static_cast<NodeSlab *>(block);
+      slab->next = slabs;
+      slab->capacity = capacity;
+      slab->used = 0;
+      slabs = slab;
+   }
 
-   int (*cmpFn)(const KeyType &, const KeyType &);
+   void *allocateNode() {
+      if (freeList != NULL) {
+         FreeNode *fp = freeList;
+         freeList = fp->next;
+         return fp;
+      }
+      if (slabs == NULL || slabs->used == slabs->capacity) {
+         int capacity = MIN_SLAB_NODES;
+         if (slabs != NULL && slabs->capacity < MAX_SLAB_NODES) {
+            capacity = 2 * slabs->capacity;
+         } else if (slabs != NULL) {
+            capacity = MAX_SLAB_NODES;
+         }
+         allocateSlab(capacity);
+      }
+      char *base = reinterpret_cast<char *>(slabs) + slabHeaderSize();
+      return base + sizeof(BSTNode) * slabs->used++;
+   }
 
-/* Private methods */
+   void recycleNode(void *storage) {
+      freeList = new (storage) FreeNode { freeList };
+   }
+
+   BSTNode *newNode(const KeyType & key, const ValueType & value) {
+      void *storage = allocateNode();
+      try {
+         return new (storage) BSTNode { key, value, NULL, NULL, NULL,
+                                        BST_IN_BALANCE };
+      } catch (...) {
+         recycleNode(storage);
+         throw;
+      }
+   }
+
+   void deleteNode(BSTNode *np) {
+      np->~BSTNode();
+      recycleNode(np);
+   }
+
+   void releasePool() {
+      while (slabs != NULL) {
+         NodeSlab *next = slabs->next;
+         ::operator delete(slabs);
+         slabs = next;
+      }
+      freeList = NULL;
+   }
 
 /*
  * Implementation notes: findNode(t, key)
  * --------------------------------------
- * Searches the tree rooted at t to find the specified key, searching
- * in the left or right subtree, as approriate.  If a matching node
+ * Searches the tree rooted at t to find the specified key, descending
+ * into the left or right subtree, as appropriate.  If a matching node
  * is found, findNode returns a pointer to the value cell in that node.
  * If no matching node exists in the tree, findNode returns NULL.
  */
 
    ValueType *findNode(BSTNode *t, const KeyType & key) const {
-      if (t == NULL)  return NULL;
-      int sign = compareKeys(key, t->key);
-      if (sign == 0) return &t->value;
-      if (sign < 0) {
-         return findNode(t->left, key);
-      } else {
-         return findNode(t->right, key);
+      while (t != NULL) {
+         if (cmp(key, t->key)) {
+            t = t->left;
+         } else if (cmp(t->key, key)) {
+            t = t->right;
+         } else {
+            return &t->value;
+         }
       }
+      return NULL;
    }
 
 /*
- * Implementation notes: addNode(t, key, heightFlag)
- * -------------------------------------------------
+ * Implementation notes: addNode(t, parent, key, heightFlag)
+ * ---------------------------------------------------------
  * Searches the tree rooted at t to find the specified key, searching
  * in the left or right subtree, as approriate.  If a matching node
  * is found, addNode returns a pointer to the value cell in that node,
  * just like findNode.  If no matching node exists in the tree, addNode
- * creates a new node with a default value.  The heightFlag reference
- * parameter returns a bool indicating whether the height of the tree
- * was changed by this operation.
+ * creates a new node with a default value as a child of parent.  The
+ * heightFlag reference parameter returns a bool indicating whether the
+ * height of the tree was changed by this operation.
  */
 
-   ValueType *addNode(BSTNode * & t, const KeyType & key, bool & heightFlag) {
+   ValueType *addNode(BSTNode * & t, BSTNode *parent, const KeyType & key,
+                      bool & heightFlag) {
       heightFlag = false;
       if (t == NULL)  {
-         t = new BSTNode();
-         t->key = key;
-         t->value = ValueType();
-         t->bf = BST_IN_BALANCE;
-         t->left = t->right = NULL;
+         t = newNode(key, ValueType());
+         t->parent = parent;
          heightFlag = true;
          nodeCount++;
          return &t->value;
@@ -304,10 +485,10 @@ private:
       ValueType *vp = NULL;
       int bfDelta = BST_IN_BALANCE;
       if (sign < 0) {
-         vp = addNode(t->left, key, heightFlag);
+         vp = addNode(t->left, t, key, heightFlag);
          if (heightFlag) bfDelta = BST_LEFT_HEAVY;
       } else {
-         vp = addNode(t->right, key, heightFlag);
+         vp = addNode(t->right, t, key, heightFlag);
          if (heightFlag) bfDelta = BST_RIGHT_HEAVY;
       }
       updateBF(t, bfDelta);
@@ -353,12 +534,14 @@ private:
       BSTNode *toDelete = t;
       if (t->left == NULL) {
          t = t->right;
-         delete toDelete;
+         if (t != NULL) t->parent = toDelete->parent;
+         deleteNode(toDelete);
          nodeCount--;
          return true;
       } else if (t->right == NULL) {
          t = t->left;
-         delete toDelete;
+         t->parent = toDelete->parent;
+         deleteNode(toDelete);
          nodeCount--;
          return true;
       } else {
@@ -437,13 +620,17 @@ private:
  * This function performs a single left rotation of the tree
  * that is passed by reference.  The balance factors
  * are unchanged by this function and must be corrected at a
- * higher level of the algorithm.
+ * higher level of the algorithm.  The parent pointers of the
+ * three nodes that move are corrected here.
  */
 
    void rotateLeft(BSTNode * & t) {
       BSTNode *child = t->right;
       t->right = child->left;
+      if (t->right != NULL) t->right->parent = t;
+      child->parent = t->parent;
       child->left = t;
+      t->parent = child;
       t = child;
    }
 
@@ -492,28 +679,61 @@ private:
  * This function performs a single right rotation of the tree
  * that is passed by reference.  The balance factors
  * are unchanged by this function and must be corrected at a
- * higher level of the algorithm.
+ * higher level of the algorithm.  The parent pointers of the
+ * three nodes that move are corrected here.
  */
 
    void rotateRight(BSTNode * & t) {
-
       BSTNode *child = t->left;
       t->left = child->right;
+      if (t->left != NULL) t->left->parent = t;
+      child->parent = t->parent;
       child->right = t;
+      t->parent = child;
       t = child;
    }
 
+/*
+ * Implementation notes: leftmostNode(t) and successorNode(t)
+ * ----------------------------------------------------------
+ * These functions implement in-order traversal using the parent
+ * pointers.  The successor of a node is the leftmost node of its right
+ * subtree if it has one; otherwise it is the nearest ancestor reached
+ * from a left child.  Each edge is crossed at most twice in a complete
+ * traversal, so a step costs O(1) amortized and allocates nothing.
+ */
+
+   static BSTNode *leftmostNode(BSTNode *t) {
+      if (t != NULL) {
+         while (t->left != NULL) {
+            t = t->left;
+         }
+      }
+      return t;
+   }
+
+   static BSTNode *successorNode(BSTNode *t) {
+      if (t->right != NULL) return leftmostNode(t->right);
+      while (t->parent != NULL && t == t->parent->right) {
+         t = t->parent;
+      }
+      return t->parent;
+   }
+
 /*
  * Implementation notes: deleteTree(t)
  * -----------------------------------
- * Deletes all the nodes in the tree.
+ * Destroys all the nodes in the tree.  Their storage belongs to the
+ * slabs, so when the node type has a trivial destructor there is
+ * nothing to do here and releasePool frees everything.
  */
 
    void deleteTree(BSTNode *t) {
+      if (std::is_trivially_destructible<BSTNode>::value) return;
       if (t != NULL) {
          deleteTree(t->left);
          deleteTree(t->right);
-         delete t;
+         t->~BSTNode();
       }
    }
 
@@ -549,23 +769,116 @@ private:
       }
    }
 
+/*
+ * Implementation notes: deepCopy and copyTree
+ * -------------------------------------------
+ * The copy reserves a single slab large enough for every node before
+ * it copies the tree, which keeps the same shape and balance factors.
+ */
+
    void deepCopy(const Map & other) {
-      root = copyTree(other.root);
+      cmp = other.cmp;
+      if (other.nodeCount > 0) allocateSlab(other.nodeCount);
+      root = copyTree(other.root, NULL);
       nodeCount = other.nodeCount;
-      cmpp = (other.cmpp == NULL) ? NULL : other.cmpp->clone();
    }
 
-   BSTNode *copyTree(BSTNode * const t) {
+   BSTNode *copyTree(BSTNode * const t, BSTNode *parent) {
       if (t == NULL) return NULL;
-      BSTNode *np = new BSTNode();
-      np->key = t->key;
-      np->value = t->value;
+      BSTNode *np = newNode(t->key, t->value);
+      np->parent = parent;
       np->bf = t->bf;
-      np->left = copyTree(t->left);
-      np->right = copyTree(t->right);
+      np->left = copyTree(t->left, np);
+      np->right = copyTree(t->right, np);
       return np;
    }
 
+/*
+ * Implementation notes: buildFromRange
+ * ------------------------------------
+ * The pairs are first copied into nodes threaded through their right
+ * pointers, checking the order as they go.  A sorted chain is turned
+ * into a tree by buildBalanced, which builds the left half of the
+ * chain, takes the next node as the root and then builds the right
+ * half.  The right half is never larger than the left, so every
+ * balance factor is either 0 or BST_LEFT_HEAVY.  An unsorted chain is
+ * added one node at a time instead.  The chain itself is built by
+ * buildChain, which takes the function that makes a node from an
+ * iterator, so that buildFromKeys can share it.
+ */
+
+   template <typename IteratorType>
+   void buildFromRange(IteratorType first, IteratorType last) {
+      buildChain(first, last, [this](IteratorType & it) {
+         return newNode(it->first, it->second);
+      });
+   }
+
+   template <typename IteratorType, typename MakeNodeType>
+   void buildChain(IteratorType first, IteratorType last,
+                   MakeNodeType makeNode) {
+      BSTNode *head = NULL;
+      BSTNode *tail = NULL;
+      int n = 0;
+      bool sorted = true;
+      try {
+         for (; first != last; ++first) {
+            BSTNode *np = makeNode(first);
+            np->right = NULL;
+            if (tail == NULL) {
+               head = np;
+            } else {
+               if (sorted && !cmp(tail->key, np->key)) sorted = false;
+               tail->right = np;
+            }
+            tail = np;
+            n++;
+         }
+      } catch (...) {
+         deleteChain(head);
+         throw;
+      }
+      if (sorted) {
+         int height;
+         root = buildBalanced(head, n, height);
+         if (root != NULL) root->parent = NULL;
+         nodeCount = n;
+      } else {
+         while (head != NULL) {
+            BSTNode *np = head;
+            head = head->right;
+            put(np->key, np->value);
+            deleteNode(np);
+         }
+      }
+   }
+
+   BSTNode *buildBalanced(BSTNode * & list, int n, int & height) {
+      if (n == 0) {
+         height = 0;
+         return NULL;
+      }
+      int leftHeight, rightHeight;
+      BSTNode *left = buildBalanced(list, n / 2, leftHeight);
+      BSTNode *np = list;
+      list = list->right;
+      np->left = left;
+      np->right = buildBalanced(list, n - n / 2 - 1, rightHeight);
+      if (np->left != NULL) np->left->parent = np;
+      if (np->right != NULL) np->right->parent = np;
+      np->bf = rightHeight - leftHeight;
+      height = 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+      return np;
+   }
+
+   void deleteChain(BSTNode *list) {
+      while (list != NULL) {
+         BSTNode *next = list->right;
+         deleteNode(list);
+         list = next;
+      }
+   }
+
 public:
 
 /*
@@ -579,11 +892,62 @@ public:
 
 /* Extended constructors */
 
-   template <typename CompareType>
-   explicit Map(CompareType cmp) {
+   template <typename FunctorType>
+   explicit Map(FunctorType fn) : cmp(fn) {
+      initPool();
+      root = NULL;
+      nodeCount = 0;
+   }
+
+   template <typename IteratorType, typename FunctorType>
+   Map(IteratorType first, IteratorType last, FunctorType fn) : cmp(fn) {
+      initPool();
       root = NULL;
       nodeCount = 0;
-      cmpp = new TemplateComparator<CompareType>(cmp);
+      buildFromRange(first, last);
+   }
+
+/*
+ * Implementation notes: buildFromKeys, copyComparator and sameOrdering
+ * --------------------------------------------------------------------
+ * These methods let Set build the result of a set operation directly.
+ * buildFromKeys replaces the contents of the map with the keys between
+ * first and last, each mapped to value, and takes linear time when the
+ * keys arrive in order.  copyComparator gives an empty map the ordering
+ * of another, so that the result of an operation orders its elements
+ * the same way as the operands.  sameOrdering returns true only when
+ * the two maps are known to order their keys identically: both use
+ * std::less through MapComparator, or the comparator type carries no
+ * state.  Two comparators that wrap arbitrary functors cannot be
+ * compared, so they count as different.
+ */
+
+   template <typename IteratorType>
+   void buildFromKeys(IteratorType first, IteratorType last,
+                      const ValueType & value) {
+      clear();
+      buildChain(first, last, [this, &value](IteratorType & it) {
+         return newNode(*it, value);
+      });
+   }
+
+   void copyComparator(const Map & src) {
+      if (!isEmpty()) error("copyComparator: map is not empty");
+      cmp = src.cmp;
+   }
+
+   bool sameOrdering(const Map & other) const {
+      return this == &other || sameComparator(cmp, other.cmp);
+   }
+
+   template <typename FunctorType>
+   static bool sameComparator(const FunctorType &, const FunctorType &) {
+      return std::is_empty<FunctorType>::value;
+   }
+
+   static bool sameComparator(const MapComparator<KeyType> & c1,
+                              const MapComparator<KeyType> & c2) {
+      return c1.usesDefaultOrder() && c2.usesDefaultOrder();
    }
 
 /*
@@ -594,8 +958,8 @@ public:
  */
 
    int compareKeys(const KeyType & k1, const KeyType & k2) const {
-      if (cmpp->lessThan(k1, k2)) return -1;
-      if (cmpp->lessThan(k2, k1)) return +1;
+      if (cmp(k1, k2)) return -1;
+      if (cmp(k2, k1)) return +1;
       return 0;
    }
 
@@ -604,7 +968,9 @@ public:
  * --------------------
  * This copy constructor and operator= are defined to make a
  * deep copy, making it possible to pass/return maps by value
- * and assign from one map to another.
+ * and assign from one map to another.  The move constructor and
+ * move assignment hand over the tree and its slabs and leave the
+ * source empty.
  */
 
    Map & operator=(const Map & src) {
@@ -616,9 +982,31 @@ public:
    }
 
    Map(const Map & src) {
+      initPool();
       deepCopy(src);
    }
 
+   Map(Map && src) : cmp(std::move(src.cmp)) {
+      root = src.root;
+      nodeCount = src.nodeCount;
+      slabs = src.slabs;
+      freeList = src.freeList;
+      src.initPool();
+      src.root = NULL;
+      src.nodeCount = 0;
+   }
+
+   Map & operator=(Map && src) {
+      if (this != &src) {
+         std::swap(root, src.root);
+         std::swap(nodeCount, src.nodeCount);
+         std::swap(slabs, src.slabs);
+         std::swap(freeList, src.freeList);
+         std::swap(cmp, src.cmp);
+      }
+      return *this;
+   }
+
 /*
  * Iterator support
  * ----------------
@@ -627,69 +1015,35 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag,KeyType> {
+   class iterator {
+
+   public:
+
+      typedef std::input_iterator_tag iterator_category;
+      typedef KeyType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef KeyType *pointer;
+      typedef KeyType & reference;
 
    private:
 
-      struct NodeMarker {
-         BSTNode *np;
-         bool processed;
-      };
-
-      const Map *mp;               /* Pointer to the map         */
-      int index;                   /* Index of current element   */
-      Stack<NodeMarker> stack;     /* Stack of unprocessed nodes */
-
-      void findLeftmostChild() {
-         BSTNode *np = stack.peek().np;
-         if (np == NULL) return;
-         while (np->left != NULL) {
-            NodeMarker marker = { np->left,  false };
-            stack.push(marker);
-            np = np->left;
-         }
-      }
+      const Map *mp;               /* Pointer to the map          */
+      BSTNode *np;                 /* Current node, NULL at end   */
 
    public:
 
       iterator() {
-        /* Empty */
+         mp = NULL;
+         np = NULL;
       }
 
       iterator(const Map *mp, bool end) {
          this->mp = mp;
-         if (end || mp->nodeCount == 0) {
-            index = mp->nodeCount;
-         } else {
-            index = 0;
-            NodeMarker marker = { mp->root, false };
-            stack.push(marker);
-            findLeftmostChild();
-         }
-      }
-
-      iterator(const iterator & it) {
-         mp = it.mp;
-         index = it.index;
-         stack = it.stack;
+         np = (end) ? NULL : leftmostNode(mp->root);
       }
 
       iterator & operator++() {
-         NodeMarker marker = stack.pop();
-         BSTNode *np = marker.np;
-         if (np->right == NULL) {
-            while (!stack.isEmpty() && stack.peek().processed) {
-               stack.pop();
-            }
-         } else {
-            marker.processed = true;
-            stack.push(marker);
-            marker.np = np->right;
-            marker.processed = false;
-            stack.push(marker);
-            findLeftmostChild();
-         }
-         index++;
+         np = successorNode(np);
          return *this;
       }
 
@@ -699,20 +1053,20 @@ public:
          return copy;
       }
 
-      bool operator==(const iterator & rhs) {
-         return mp == rhs.mp && index == rhs.index;
+      bool operator==(const iterator & rhs) const {
+         return mp == rhs.mp && np == rhs.np;
       }
 
-      bool operator!=(const iterator & rhs) {
+      bool operator!=(const iterator & rhs) const {
          return !(*this == rhs);
       }
 
-      KeyType operator*() {
-         return stack.peek().np->key;
+      const KeyType & operator*() const {
+         return np->key;
       }
 
-      KeyType *operator->() {
-         return &stack.peek().np->key;
+      const KeyType *operator->() const {
+         return &np->key;
       }
 
       friend class Map;
@@ -729,90 +1083,101 @@ public:
 
 };
 
-template <typename KeyType, typename ValueType>
-Map<KeyType,ValueType>::Map() {
+template <typename KeyType, typename ValueType, typename CompareType>
+Map<KeyType,ValueType,CompareType>::Map() {
+   initPool();
+   root = NULL;
+   nodeCount = 0;
+}
+
+template <typename KeyType, typename ValueType, typename CompareType>
+template <typename IteratorType>
+Map<KeyType,ValueType,CompareType>::Map(IteratorType first,
+                                        IteratorType last) {
+   initPool();
    root = NULL;
    nodeCount = 0;
-   cmpp = new TemplateComparator< less<KeyType> >(less<KeyType>());
+   buildFromRange(first, last);
 }
 
-template <typename KeyType, typename ValueType>
-Map<KeyType,ValueType>::~Map() {
-   if (cmpp != NULL) delete cmpp;
+template <typename KeyType, typename ValueType, typename CompareType>
+Map<KeyType,ValueType,CompareType>::~Map() {
    deleteTree(root);
+   releasePool();
 }
 
-template <typename KeyType, typename ValueType>
-int Map<KeyType,ValueType>::size() const {
+template <typename KeyType, typename ValueType, typename CompareType>
+int Map<KeyType,ValueType,CompareType>::size() const {
    return nodeCount;
 }
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType,ValueType>::isEmpty() const {
+template <typename KeyType, typename ValueType, typename CompareType>
+bool Map<KeyType,ValueType,CompareType>::isEmpty() const {
    return nodeCount == 0;
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType,ValueType>::put(const KeyType & key,
+template <typename KeyType, typename ValueType, typename CompareType>
+void Map<KeyType,ValueType,CompareType>::put(const KeyType & key,
                                  const ValueType & value) {
    bool dummy;
-   *addNode(root, key, dummy) = value;
+   *addNode(root, NULL, key, dummy) = value;
 }
 
-template <typename KeyType, typename ValueType>
-ValueType Map<KeyType,ValueType>::get(const KeyType & key) const {
+template <typename KeyType, typename ValueType, typename CompareType>
+ValueType Map<KeyType,ValueType,CompareType>::get(const KeyType & key) const {
    ValueType *vp = findNode(root, key);
    if (vp == NULL) return ValueType();
    return *vp;
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType,ValueType>::remove(const KeyType & key) {
+template <typename KeyType, typename ValueType, typename CompareType>
+void Map<KeyType,ValueType,CompareType>::remove(const KeyType & key) {
    removeNode(root, key);
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType,ValueType>::clear() {
+template <typename KeyType, typename ValueType, typename CompareType>
+void Map<KeyType,ValueType,CompareType>::clear() {
    deleteTree(root);
+   releasePool();
    root = NULL;
    nodeCount = 0;
 }
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType,ValueType>::containsKey(const KeyType & key) const {
+template <typename KeyType, typename ValueType, typename CompareType>
+bool Map<KeyType,ValueType,CompareType>::containsKey(const KeyType & key) const {
    return findNode(root, key) != NULL;
 }
 
-template <typename KeyType, typename ValueType>
-ValueType & Map<KeyType,ValueType>::operator[](const KeyType & key) {
+template <typename KeyType, typename ValueType, typename CompareType>
+ValueType & Map<KeyType,ValueType,CompareType>::operator[](const KeyType & key) {
    bool dummy;
-   return *addNode(root, key, dummy);
+   return *addNode(root, NULL, key, dummy);
 }
 
-template <typename KeyType, typename ValueType>
-ValueType Map<KeyType,ValueType>::operator[](const KeyType & key) const {
+template <typename KeyType, typename ValueType, typename CompareType>
+ValueType Map<KeyType,ValueType,CompareType>::operator[](const KeyType & key) const {
    return get(key);
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType,ValueType>::mapAll(void (*fn)(KeyType, ValueType)) const {
+template <typename KeyType, typename ValueType, typename CompareType>
+void Map<KeyType,ValueType,CompareType>::mapAll(void (*fn)(KeyType, ValueType)) const {
    mapAll(root, fn);
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType,ValueType>::mapAll(void (*fn)(const KeyType &,
+template <typename KeyType, typename ValueType, typename CompareType>
+void Map<KeyType,ValueType,CompareType>::mapAll(void (*fn)(const KeyType &,
                                                const ValueType &)) const {
    mapAll(root, fn);
 }
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename CompareType>
 template <typename FunctorType>
-void Map<KeyType,ValueType>::mapAll(FunctorType fn) const {
+void Map<KeyType,ValueType,CompareType>::mapAll(FunctorType fn) const {
    mapAll(root, fn);
 }
 
-template <typename KeyType, typename ValueType>
-std::string Map<KeyType,ValueType>::toString() {
+template <typename KeyType, typename ValueType, typename CompareType>
+std::string Map<KeyType,ValueType,CompareType>::toString() {
    ostringstream os;
    os << *this;
    return os.str();
@@ -826,13 +1191,13 @@ std::string Map<KeyType,ValueType>::toString() {
  * specially.
  */
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename CompareType>
 std::ostream & operator<<(std::ostream & os,
-                          const Map<KeyType,ValueType> & map) {
+                          const Map<KeyType,ValueType,CompareType> & map) {
    os << "{";
-   typename Map<KeyType,ValueType>::iterator begin = map.begin();
-   typename Map<KeyType,ValueType>::iterator end = map.end();
-   typename Map<KeyType,ValueType>::iterator it = begin;
+   typename Map<KeyType,ValueType,CompareType>::iterator begin = map.begin();
+   typename Map<KeyType,ValueType,CompareType>::iterator end = map.end();
+   typename Map<KeyType,ValueType,CompareType>::iterator it = begin;
    while (it != end) {
       if (it != begin) os << ", ";
       writeGenericValue(os, *it, false);
@@ -843,8 +1208,8 @@ std::ostream & operator<<(std::ostream & os,
    return os << "}";
 }
 
-template <typename KeyType, typename ValueType>
-std::istream & operator>>(std::istream & is, Map<KeyType,ValueType> & map) {
+template <typename KeyType, typename ValueType, typename CompareType>
+std::istream & operator>>(std::istream & is, Map<KeyType,ValueType,CompareType> & map) {
    char ch;
    is >> ch;
    if (ch != '{') error("operator >>: Missing {");
@@ -2,25 +2,37 @@
  * File: pqueue.h
  * --------------
  * This file exports the <code>PriorityQueue</code> class, a
- * collection in which values are processed in priority order.
+ * collection in which values are processed in priority order, and
+ * the <code>IndexedPriorityQueue</code> class, which also allows the
+ * priority of a queued entry to be changed.
  */
 
 #ifndef _pqueue_h
 #define _pqueue_h
 
+#include <functional>
+#include <utility>
 #include "vector.h"
 
 /*
- * Class: PriorityQueue<ValueType>
- * -------------------------------
+ * Class: PriorityQueue<ValueType,PriorityType,CompareType>
+ * --------------------------------------------------------
  * This class models a structure called a <b><i>priority&nbsp;queue</i></b>
  * in which values are processed in order of priority.  As in conventional
  * English usage, lower priority numbers correspond to higher effective
  * priorities, so that a priority 1 item takes precedence over a
  * priority 2 item.
+ *
+ * Priorities are <code>double</code> values unless the optional second
+ * template parameter names another type.  The optional third parameter
+ * names the functor that decides which of two priorities comes first;
+ * it defaults to <code>std::less</code>, which gives the ordering
+ * described above.  Values are moved into and out of the queue, so
+ * move-only types such as <code>std::unique_ptr</code> may be queued.
  */
 
-template <typename ValueType>
+template <typename ValueType, typename PriorityType = double,
+          typename CompareType = std::less<PriorityType> >
 class PriorityQueue {
 
 public:
@@ -28,11 +40,14 @@ public:
 /*
  * Constructor: PriorityQueue
  * Usage: PriorityQueue<ValueType> pq;
- * -----------------------------------
- * Initializes a new priority queue, which is initially empty.
+ *        PriorityQueue<ValueType,PriorityType,CompareType> pq(cmp);
+ * ----------------------------------------------------------------
+ * Initializes a new priority queue, which is initially empty.  The
+ * second form supplies the comparison functor.
  */
 
    PriorityQueue();
+   explicit PriorityQueue(CompareType cmp);
 
 /*
  * Destructor: ~PriorityQueue
@@ -79,7 +94,7 @@ public:
  * priority 2 elements.
  */
 
-   void enqueue(ValueType value, double priority);
+   void enqueue(ValueType value, PriorityType priority);
 
 /*
  * Method: dequeue
@@ -104,13 +119,13 @@ public:
 
 /*
  * Method: peekPriority
- * Usage: double priority = pq.peekPriority();
- * -------------------------------------------
+ * Usage: PriorityType priority = pq.peekPriority();
+ * -------------------------------------------------
  * Returns the priority of the first element in the queue, without
  * removing it.
  */
 
-   double peekPriority() const;
+   PriorityType peekPriority() const;
 
 /*
  * Method: front
@@ -130,6 +145,16 @@ public:
 
    ValueType & back();
 
+/*
+ * Method: reserve
+ * Usage: pq.reserve(n);
+ * ---------------------
+ * Makes room for at least <code>n</code> entries, so that the queue
+ * can grow to that size without reallocating its storage.
+ */
+
+   void reserve(int n);
+
 /*
  * Method: toString
  * Usage: string str = pq.toString();
@@ -150,41 +175,290 @@ public:
  * Implementation notes: PriorityQueue data structure
  * --------------------------------------------------
  * The PriorityQueue class is implemented using a data structure called
- * a heap.
+ * a heap.  The heap is 4-ary: the children of entry i are the entries
+ * 4i+1 through 4i+4.  A 4-ary heap is half as deep as a binary heap,
+ * and the four children of a node sit next to each other in memory,
+ * so a dequeue touches fewer cache lines even though each level makes
+ * more comparisons.  Entries are moved through a hole rather than
+ * swapped, so each level costs one move instead of three.
  */
 
 private:
 
+/* Constant definitions */
+
+   static const int HEAP_ARITY = 4;
+
 /* Type used for each heap entry */
 
    struct HeapEntry {
       ValueType value;
-      double priority;
+      PriorityType priority;
       long sequence;
    };
 
 /* Instance variables */
 
-   Vector<HeapEntry> heap;
-   long enqueueCount;
-   int backIndex;
-   int count;
-   int capacity;
+   Vector<HeapEntry> heap;       /* The heap, with the first entry at 0 */
+   long enqueueCount;            /* Sequence number for the next entry  */
+   int backIndex;                /* Index of the lowest priority entry  */
+   mutable CompareType cmp;      /* Orders two priorities               */
 
 /* Private function prototypes */
 
-   void enqueueHeap(ValueType & value, double priority);
-   ValueType dequeueHeap();
-   bool takesPriority(int i1, int i2);
-   void swapHeapEntries(int i1, int i2);
+   bool takesPriority(const HeapEntry & e1, const HeapEntry & e2) const;
+   void siftUp(int index);
+   void siftDown(int index);
+
+public:
+
+/*
+ * Deep copying support
+ * --------------------
+ * This copy constructor and operator= are defined to make a deep copy,
+ * making it possible to pass or return priority queues by value and
+ * assign from one queue to another.  The move constructor and move
+ * assignment take over the heap of a queue that is about to be
+ * discarded.
+ */
+
+   PriorityQueue(const PriorityQueue & src)
+      : heap(src.heap), cmp(src.cmp) {
+      enqueueCount = src.enqueueCount;
+      backIndex = src.backIndex;
+   }
+
+   PriorityQueue & operator=(const PriorityQueue & src) {
+      if (this != &src) {
+         heap = src.heap;
+         enqueueCount = src.enqueueCount;
+         backIndex = src.backIndex;
+         cmp = src.cmp;
+      }
+      return *this;
+   }
+
+   PriorityQueue(PriorityQueue && src)
+      : heap(std::move(src.heap)), cmp(std::move(src.cmp)) {
+      enqueueCount = src.enqueueCount;
+      backIndex = src.backIndex;
+      src.backIndex = 0;
+   }
+
+   PriorityQueue & operator=(PriorityQueue && src) {
+      if (this != &src) {
+         heap = std::move(src.heap);
+         enqueueCount = src.enqueueCount;
+         backIndex = src.backIndex;
+         cmp = std::move(src.cmp);
+         src.backIndex = 0;
+      }
+      return *this;
+   }
+
+};
+
+/*
+ * Class: IndexedPriorityQueue<PriorityType,CompareType>
+ * -----------------------------------------------------
+ * This class is a priority queue of integer indices, each of which may
+ * be queued at most once.  Because the queue knows where every index
+ * sits, it can change the priority of a queued index or remove it in
+ * logarithmic time, which makes it suitable for algorithms such as
+ * Dijkstra's that repeatedly lower the priority of waiting entries.
+ * Clients typically use the index as a subscript into their own
+ * vector of objects.  The template parameters have the same meaning
+ * as for <code>PriorityQueue</code>.
+ */
+
+template <typename PriorityType = double,
+          typename CompareType = std::less<PriorityType> >
+class IndexedPriorityQueue {
+
+public:
+
+/*
+ * Constructor: IndexedPriorityQueue
+ * Usage: IndexedPriorityQueue<> pq;
+ *        IndexedPriorityQueue<PriorityType,CompareType> pq(cmp);
+ * ------------------------------------------------------------
+ * Initializes a new indexed priority queue, which is initially empty.
+ */
+
+   IndexedPriorityQueue();
+   explicit IndexedPriorityQueue(CompareType cmp);
+
+/*
+ * Method: size
+ * Usage: int n = pq.size();
+ * -------------------------
+ * Returns the number of indices in the priority queue.
+ */
+
+   int size() const;
+
+/*
+ * Method: isEmpty
+ * Usage: if (pq.isEmpty()) ...
+ * ----------------------------
+ * Returns <code>true</code> if the priority queue contains no indices.
+ */
+
+   bool isEmpty() const;
+
+/*
+ * Method: clear
+ * Usage: pq.clear();
+ * ------------------
+ * Removes all indices from the priority queue.
+ */
+
+   void clear();
+
+/*
+ * Method: enqueue
+ * Usage: pq.enqueue(index, priority);
+ * -----------------------------------
+ * Adds the nonnegative <code>index</code> to the queue with the
+ * specified priority.  It is an error to enqueue an index that is
+ * already in the queue.
+ */
+
+   void enqueue(int index, PriorityType priority);
+
+/*
+ * Method: dequeue
+ * Usage: int first = pq.dequeue();
+ * --------------------------------
+ * Removes and returns the index with the highest priority.  Indices
+ * with the same priority are dequeued in the order in which they were
+ * enqueued or last had their priority changed.
+ */
+
+   int dequeue();
+
+/*
+ * Method: peek
+ * Usage: int first = pq.peek();
+ * -----------------------------
+ * Returns the index with the highest priority, without removing it.
+ */
+
+   int peek() const;
+
+/*
+ * Method: peekPriority
+ * Usage: PriorityType priority = pq.peekPriority();
+ * -------------------------------------------------
+ * Returns the priority of the first index in the queue, without
+ * removing it.
+ */
+
+   PriorityType peekPriority() const;
+
+/*
+ * Method: contains
+ * Usage: if (pq.contains(index)) ...
+ * ----------------------------------
+ * Returns <code>true</code> if <code>index</code> is in the queue.
+ */
+
+   bool contains(int index) const;
+
+/*
+ * Method: getPriority
+ * Usage: PriorityType priority = pq.getPriority(index);
+ * -----------------------------------------------------
+ * Returns the priority of <code>index</code>, which must be in the
+ * queue.
+ */
+
+   PriorityType getPriority(int index) const;
+
+/*
+ * Method: changePriority
+ * Usage: pq.changePriority(index, priority);
+ * ------------------------------------------
+ * Gives <code>index</code>, which must be in the queue, a new priority
+ * and moves it to its new place in O(log n) time.  The priority may go
+ * up or down.
+ */
+
+   void changePriority(int index, PriorityType priority);
+
+/*
+ * Method: remove
+ * Usage: pq.remove(index);
+ * ------------------------
+ * Removes <code>index</code> from the queue if it is there.
+ */
+
+   void remove(int index);
+
+/* Private section */
+
+/**********************************************************************/
+/* Note: Everything below this point in the file is logically part    */
+/* of the implementation and should not be of interest to clients.    */
+/**********************************************************************/
+
+/*
+ * Implementation notes: IndexedPriorityQueue data structure
+ * ---------------------------------------------------------
+ * The heap has the same 4-ary layout as in PriorityQueue.  Alongside
+ * it, the position vector records for every index the heap slot that
+ * holds it, or -1 if the index is not queued; each time the sift
+ * operations move an entry they update its position, so an index can
+ * be found without a search.  The position vector grows to cover the
+ * largest index ever enqueued.
+ */
+
+private:
+
+/* Constant definitions */
+
+   static const int HEAP_ARITY = 4;
+
+/* Type used for each heap entry */
+
+   struct HeapEntry {
+      int index;
+      PriorityType priority;
+      long sequence;
+   };
+
+/* Instance variables */
+
+   Vector<HeapEntry> heap;       /* The heap, with the first entry at 0 */
+   Vector<int> position;         /* Heap slot of each index, or -1      */
+   long enqueueCount;            /* Sequence number for the next entry  */
+   mutable CompareType cmp;      /* Orders two priorities               */
+
+/* Private function prototypes */
+
+   bool takesPriority(const HeapEntry & e1, const HeapEntry & e2) const;
+   void place(int slot, HeapEntry & entry);
+   void siftUp(int slot);
+   void siftDown(int slot);
+   void fixSlot(int slot);
+   int findSlot(int index, std::string method) const;
 
 };
 
 extern void error(std::string msg);
 
-template <typename ValueType>
-PriorityQueue<ValueType>::PriorityQueue() {
-   clear();
+template <typename ValueType, typename PriorityType, typename CompareType>
+PriorityQueue<ValueType,PriorityType,CompareType>::PriorityQueue() {
+   enqueueCount = 0;
+   backIndex = 0;
+}
+
+template <typename ValueType, typename PriorityType, typename CompareType>
+PriorityQueue<ValueType,PriorityType,CompareType>::PriorityQueue(
+                                                  CompareType cmp)
+   : cmp(cmp) {
+   enqueueCount = 0;
+   backIndex = 0;
 }
 
 /*
@@ -194,133 +468,190 @@ PriorityQueue<ValueType>::PriorityQueue() {
  * so no work is required at this level.
  */
 
-template <typename ValueType>
-PriorityQueue<ValueType>::~PriorityQueue() {
+template <typename ValueType, typename PriorityType, typename CompareType>
+PriorityQueue<ValueType,PriorityType,CompareType>::~PriorityQueue() {
    /* Empty */
 }
 
-template <typename ValueType>
-int PriorityQueue<ValueType>::size() const {
-   return count;
+template <typename ValueType, typename PriorityType, typename CompareType>
+int PriorityQueue<ValueType,PriorityType,CompareType>::size() const {
+   return heap.size();
 }
 
-template <typename ValueType>
-bool PriorityQueue<ValueType>::isEmpty() const {
-   return count == 0;
+template <typename ValueType, typename PriorityType, typename CompareType>
+bool PriorityQueue<ValueType,PriorityType,CompareType>::isEmpty() const {
+   return heap.isEmpty();
 }
 
-template <typename ValueType>
-void PriorityQueue<ValueType>::clear() {
+template <typename ValueType, typename PriorityType, typename CompareType>
+void PriorityQueue<ValueType,PriorityType,CompareType>::clear() {
    heap.clear();
-   count = 0;
+   backIndex = 0;
 }
 
-template <typename ValueType>
-void PriorityQueue<ValueType>::enqueue(ValueType value, double priority) {
-   if (count == heap.size()) heap.add(HeapEntry());
-   int index = count++;
-   heap[index].value = value;
-   heap[index].priority = priority;
-   heap[index].sequence = enqueueCount++;
-   if (index == 0 || takesPriority(backIndex, index)) backIndex = index;
-   while (index > 0) {
-      int parent = (index - 1) / 2;
-      if (takesPriority(parent, index)) break;
-      swapHeapEntries(parent, index);
-      index = parent;
+template <typename ValueType, typename PriorityType, typename CompareType>
+void PriorityQueue<ValueType,PriorityType,CompareType>::reserve(int n) {
+   heap.reserve(n);
+}
+
+/*
+ * Implementation notes: enqueue
+ * -----------------------------
+ * The new entry is added at the end of the heap and sifted up.  It
+ * becomes the back of the queue if it ranks after the current back.
+ */
+
+template <typename ValueType, typename PriorityType, typename CompareType>
+void PriorityQueue<ValueType,PriorityType,CompareType>::enqueue(
+                                                  ValueType value,
+                                                  PriorityType priority) {
+   HeapEntry entry = { std::move(value), std::move(priority),
+                       enqueueCount++ };
+   heap.add(std::move(entry));
+   int index = heap.size() - 1;
+   if (index == 0 || takesPriority(heap[backIndex], heap[index])) {
+      backIndex = index;
    }
+   siftUp(index);
 }
 
 /*
  * Implementation notes: dequeue, peek, peekPriority
  * -------------------------------------------------
  * These methods must check for an empty queue and report an error
- * if there is no first element.
+ * if there is no first element.  The dequeue method moves the last
+ * entry into the root and sifts it down.
  */
 
-template <typename ValueType>
-ValueType PriorityQueue<ValueType>::dequeue() {
-   if (count == 0) error("dequeue: Attempting to dequeue an empty queue");
-   count--;
-   bool wasBack = (backIndex == count);
-   ValueType value = heap[0].value;
-   swapHeapEntries(0, count);
-   int index = 0;
-   while (true) {
-      int left = 2 * index + 1;
-      int right = 2 * index + 2;
-      if (left >= count) break;
-      int child = left;
-      if (right < count && takesPriority(right, left)) child = right;
-      if (takesPriority(index, child)) break;
-      swapHeapEntries(index, child);
-      index = child;
+template <typename ValueType, typename PriorityType, typename CompareType>
+ValueType PriorityQueue<ValueType,PriorityType,CompareType>::dequeue() {
+   if (heap.isEmpty()) error("dequeue: Attempting to dequeue an empty queue");
+   ValueType value = std::move(heap[0].value);
+   int last = heap.size() - 1;
+   if (last > 0) {
+      heap[0] = std::move(heap[last]);
+      if (backIndex == last) backIndex = 0;
    }
-   if (wasBack) backIndex = index;
+   heap.remove(last);
+   if (last > 1) siftDown(0);
    return value;
 }
 
-template <typename ValueType>
-ValueType PriorityQueue<ValueType>::peek() const {
-   if (count == 0) error("peek: Attempting to peek at an empty queue");
-   return heap.get(0).value;
+template <typename ValueType, typename PriorityType, typename CompareType>
+ValueType PriorityQueue<ValueType,PriorityType,CompareType>::peek() const {
+   if (heap.isEmpty()) error("peek: Attempting to peek at an empty queue");
+   return heap[0].value;
 }
 
-template <typename ValueType>
-double PriorityQueue<ValueType>::peekPriority() const {
-   if (count == 0) error("peekPriority: Attempting to peek at an empty queue");
-   return heap.get(0).priority;
+template <typename ValueType, typename PriorityType, typename CompareType>
+PriorityType
+PriorityQueue<ValueType,PriorityType,CompareType>::peekPriority() const {
+   if (heap.isEmpty()) {
+      error("peekPriority: Attempting to peek at an empty queue");
+   }
+   return heap[0].priority;
 }
 
-template <typename ValueType>
-ValueType & PriorityQueue<ValueType>::front() {
-   if (count == 0) error("front: Attempting to read front of an empty queue");
-   return heap.get(0).value;
+template <typename ValueType, typename PriorityType, typename CompareType>
+ValueType & PriorityQueue<ValueType,PriorityType,CompareType>::front() {
+   if (heap.isEmpty()) {
+      error("front: Attempting to read front of an empty queue");
+   }
+   return heap[0].value;
 }
 
-template <typename ValueType>
-ValueType & PriorityQueue<ValueType>::back() {
-   if (count == 0) error("back: Attempting to read back of an empty queue");
-   return heap.get(backIndex).value;
+template <typename ValueType, typename PriorityType, typename CompareType>
+ValueType & PriorityQueue<ValueType,PriorityType,CompareType>::back() {
+   if (heap.isEmpty()) {
+      error("back: Attempting to read back of an empty queue");
+   }
+   return heap[backIndex].value;
 }
 
-template <typename ValueType>
-bool PriorityQueue<ValueType>::takesPriority(int i1, int i2) {
-   if (heap[i1].priority < heap[i2].priority) return true;
-   if (heap[i1].priority > heap[i2].priority) return false;
-   return (heap[i1].sequence < heap[i2].sequence);
+template <typename ValueType, typename PriorityType, typename CompareType>
+bool PriorityQueue<ValueType,PriorityType,CompareType>::takesPriority(
+                                                  const HeapEntry & e1,
+                                                  const HeapEntry & e2) const {
+   if (cmp(e1.priority, e2.priority)) return true;
+   if (cmp(e2.priority, e1.priority)) return false;
+   return e1.sequence < e2.sequence;
 }
 
-template <typename ValueType>
-void PriorityQueue<ValueType>::swapHeapEntries(int i1, int i2) {
-   HeapEntry entry = heap[i1];
-   heap[i1] = heap[i2];
-   heap[i2] = entry;
+/*
+ * Implementation notes: siftUp, siftDown
+ * --------------------------------------
+ * Both methods lift the entry at index out of the heap, leaving a
+ * hole, and move the hole up toward the root or down toward the
+ * leaves until the entry can be dropped into it.  Any entry that
+ * moves carries backIndex with it if it is the back of the queue.
+ */
+
+template <typename ValueType, typename PriorityType, typename CompareType>
+void PriorityQueue<ValueType,PriorityType,CompareType>::siftUp(int index) {
+   HeapEntry *entries = &heap[0];
+   bool movingBack = (backIndex == index);
+   HeapEntry entry = std::move(entries[index]);
+   while (index > 0) {
+      int parent = (index - 1) / HEAP_ARITY;
+      if (!takesPriority(entry, entries[parent])) break;
+      entries[index] = std::move(entries[parent]);
+      if (backIndex == parent) backIndex = index;
+      index = parent;
+   }
+   entries[index] = std::move(entry);
+   if (movingBack) backIndex = index;
+}
+
+template <typename ValueType, typename PriorityType, typename CompareType>
+void PriorityQueue<ValueType,PriorityType,CompareType>::siftDown(int index) {
+   HeapEntry *entries = &heap[0];
+   int n = heap.size();
+   bool movingBack = (backIndex == index);
+   HeapEntry entry = std::move(entries[index]);
+   while (true) {
+      int first = HEAP_ARITY * index + 1;
+      if (first >= n) break;
+      int end = (first + HEAP_ARITY < n) ? first + HEAP_ARITY : n;
+      int best = first;
+      for (int child = first + 1; child < end; child++) {
+         if (takesPriority(entries[child], entries[best])) best = child;
+      }
+      if (!takesPriority(entries[best], entry)) break;
+      entries[index] = std::move(entries[best]);
+      if (backIndex == best) backIndex = index;
+      index = best;
+   }
+   entries[index] = std::move(entry);
+   if (movingBack) backIndex = index;
 }
 
-template <typename ValueType>
-std::string PriorityQueue<ValueType>::toString() {
+template <typename ValueType, typename PriorityType, typename CompareType>
+std::string PriorityQueue<ValueType,PriorityType,CompareType>::toString() {
    ostringstream os;
    os << *this;
    return os.str();
 }
 
-template <typename ValueType>
-std::ostream & operator<<(std::ostream & os,
-                          const PriorityQueue<ValueType> & pq) {
+template <typename ValueType, typename PriorityType, typename CompareType>
+std::ostream &
+operator<<(std::ostream & os,
+           const PriorityQueue<ValueType,PriorityType,CompareType> & pq) {
    os << "{";
-   PriorityQueue<ValueType> copy = pq;
+   PriorityQueue<ValueType,PriorityType,CompareType> copy = pq;
    int len = pq.size();
    for (int i = 0; i < len; i++) {
       if (i > 0) os << ", ";
-      os << copy.peekPriority() << ":";
+      writeGenericValue(os, copy.peekPriority(), false);
+      os << ":";
       writeGenericValue(os, copy.dequeue(), true);
    }
    return os << "}";
 }
 
-template <typename ValueType>
-std::istream & operator>>(std::istream & is, PriorityQueue<ValueType> & pq) {
+template <typename ValueType, typename PriorityType, typename CompareType>
+std::istream &
+operator>>(std::istream & is,
+           PriorityQueue<ValueType,PriorityType,CompareType> & pq) {
    char ch;
    is >> ch;
    if (ch != '{') error("operator >>: Missing {");
@@ -329,8 +660,9 @@ std::istream & operator>>(std::istream & is, PriorityQueue<ValueType> & pq) {
    if (ch != '}') {
       is.unget();
       while (true) {
-         double priority;
-         is >> priority >> ch;
+         PriorityType priority;
+         readGenericValue(is, priority);
+         is >> ch;
          if (ch != ':') error("operator >>: Missing colon after priority");
          ValueType value;
          readGenericValue(is, value);
@@ -345,4 +677,186 @@ std::istream & operator>>(std::istream & is, PriorityQueue<ValueType> & pq) {
    return is;
 }
 
+template <typename PriorityType, typename CompareType>
+IndexedPriorityQueue<PriorityType,CompareType>::IndexedPriorityQueue() {
+   enqueueCount = 0;
+}
+
+template <typename PriorityType, typename CompareType>
+IndexedPriorityQueue<PriorityType,CompareType>::IndexedPriorityQueue(
+                                                  CompareType cmp)
+   : cmp(cmp) {
+   enqueueCount = 0;
+}
+
+template <typename PriorityType, typename CompareType>
+int IndexedPriorityQueue<PriorityType,CompareType>::size() const {
+   return heap.size();
+}
+
+template <typename PriorityType, typename CompareType>
+bool IndexedPriorityQueue<PriorityType,CompareType>::isEmpty() const {
+   return heap.isEmpty();
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::clear() {
+   heap.clear();
+   position.clear();
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::enqueue(
+                                                  int index,
+                                                  PriorityType priority) {
+   if (index < 0) error("enqueue: Index must be nonnegative");
+   if (contains(index)) error("enqueue: Index is already in the queue");
+   while (position.size() <= index) {
+      position.add(-1);
+   }
+   HeapEntry entry = { index, std::move(priority), enqueueCount++ };
+   heap.add(std::move(entry));
+   position[index] = heap.size() - 1;
+   siftUp(heap.size() - 1);
+}
+
+template <typename PriorityType, typename CompareType>
+int IndexedPriorityQueue<PriorityType,CompareType>::dequeue() {
+   if (heap.isEmpty()) error("dequeue: Attempting to dequeue an empty queue");
+   int index = heap[0].index;
+   remove(index);
+   return index;
+}
+
+template <typename PriorityType, typename CompareType>
+int IndexedPriorityQueue<PriorityType,CompareType>::peek() const {
+   if (heap.isEmpty()) error("peek: Attempting to peek at an empty queue");
+   return heap[0].index;
+}
+
+template <typename PriorityType, typename CompareType>
+PriorityType
+IndexedPriorityQueue<PriorityType,CompareType>::peekPriority() const {
+   if (heap.isEmpty()) {
+      error("peekPriority: Attempting to peek at an empty queue");
+   }
+   return heap[0].priority;
+}
+
+template <typename PriorityType, typename CompareType>
+bool IndexedPriorityQueue<PriorityType,CompareType>::contains(
+                                                  int index) const {
+   return index >= 0 && index < position.size() && position[index] >= 0;
+}
+
+template <typename PriorityType, typename CompareType>
+PriorityType IndexedPriorityQueue<PriorityType,CompareType>::getPriority(
+                                                  int index) const {
+   return heap[findSlot(index, "getPriority")].priority;
+}
+
+/*
+ * Implementation notes: changePriority, remove
+ * --------------------------------------------
+ * A changed entry takes a fresh sequence number, as if it had been
+ * enqueued again.  A removed entry is replaced by the last entry in the
+ * heap.  In both cases the entry in the affected slot may now belong
+ * either above or below it, and fixSlot sifts it whichever way it
+ * needs to go.
+ */
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::changePriority(
+                                                  int index,
+                                                  PriorityType priority) {
+   int slot = findSlot(index, "changePriority");
+   heap[slot].priority = std::move(priority);
+   heap[slot].sequence = enqueueCount++;
+   fixSlot(slot);
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::remove(int index) {
+   if (!contains(index)) return;
+   int slot = position[index];
+   int last = heap.size() - 1;
+   position[index] = -1;
+   if (slot != last) {
+      place(slot, heap[last]);
+   }
+   heap.remove(last);
+   if (slot != last) fixSlot(slot);
+}
+
+template <typename PriorityType, typename CompareType>
+bool IndexedPriorityQueue<PriorityType,CompareType>::takesPriority(
+                                                  const HeapEntry & e1,
+                                                  const HeapEntry & e2) const {
+   if (cmp(e1.priority, e2.priority)) return true;
+   if (cmp(e2.priority, e1.priority)) return false;
+   return e1.sequence < e2.sequence;
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::place(int slot,
+                                                  HeapEntry & entry) {
+   heap[slot] = std::move(entry);
+   position[heap[slot].index] = slot;
+}
+
+/*
+ * Implementation notes: siftUp, siftDown
+ * --------------------------------------
+ * These work as in PriorityQueue, except that every entry moved into
+ * a slot has its position updated by place.
+ */
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::siftUp(int slot) {
+   HeapEntry entry = std::move(heap[slot]);
+   while (slot > 0) {
+      int parent = (slot - 1) / HEAP_ARITY;
+      if (!takesPriority(entry, heap[parent])) break;
+      place(slot, heap[parent]);
+      slot = parent;
+   }
+   place(slot, entry);
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::siftDown(int slot) {
+   int n = heap.size();
+   HeapEntry entry = std::move(heap[slot]);
+   while (true) {
+      int first = HEAP_ARITY * slot + 1;
+      if (first >= n) break;
+      int end = (first + HEAP_ARITY < n) ? first + HEAP_ARITY : n;
+      int best = first;
+      for (int child = first + 1; child < end; child++) {
+         if (takesPriority(heap[child], heap[best])) best = child;
+      }
+      if (!takesPriority(heap[best], entry)) break;
+      place(slot, heap[best]);
+      slot = best;
+   }
+   place(slot, entry);
+}
+
+template <typename PriorityType, typename CompareType>
+void IndexedPriorityQueue<PriorityType,CompareType>::fixSlot(int slot) {
+   if (slot > 0 && takesPriority(heap[slot], heap[(slot - 1) / HEAP_ARITY])) {
+      siftUp(slot);
+   } else {
+      siftDown(slot);
+   }
+}
+
+template <typename PriorityType, typename CompareType>
+int IndexedPriorityQueue<PriorityType,CompareType>::findSlot(
+                                                  int index,
+                                                  std::string method) const {
+   if (!contains(index)) error(method + ": Index is not in the queue");
+   return position[index];
+}
+
 #endif
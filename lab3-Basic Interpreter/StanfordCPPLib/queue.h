@@ -9,6 +9,10 @@
 #ifndef _queue_h
 #define _queue_h
 
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "vector.h"
 
 /*
@@ -78,6 +82,16 @@ public:
 
    void enqueue(ValueType value);
 
+/*
+ * Method: reserve
+ * Usage: queue.reserve(n);
+ * ------------------------
+ * Makes room for at least <code>n</code> values, so that the queue
+ * can grow to that size without reallocating its storage.
+ */
+
+   void reserve(int n);
+
 /*
  * Method: dequeue
  * Usage: ValueType first = queue.dequeue();
@@ -141,17 +155,46 @@ public:
 
 private:
 
+/* Constant definitions */
+
+   static const int INITIAL_CAPACITY = 16;
+
 /* Instance variables */
 
-   Vector<ValueType> ringBuffer;
-   int count;
-   int capacity;
-   int head;
-   int tail;
+   ValueType *elements;        /* Raw storage for the ring buffer     */
+   int capacity;               /* Zero or a power of two              */
+   int head;                   /* Index of the first element          */
+   int count;                  /* Number of elements in the queue     */
 
 /* Private functions */
 
+   static ValueType *allocate(int n);
+   static void release(ValueType *array);
+   static void moveElements(ValueType *dst, ValueType *src, int n);
+   void reallocate(int newCapacity);
    void expandRingBufferCapacity();
+   void destroyAll();
+   void deepCopy(const Queue & src);
+
+   int slotIndex(int offset) const {
+      return (head + offset) & (capacity - 1);
+   }
+
+public:
+
+/*
+ * Deep copying support
+ * --------------------
+ * This copy constructor and operator= are defined to make a deep copy,
+ * making it possible to pass or return queues by value and assign
+ * from one queue to another.  The move constructor and move
+ * assignment take over the ring buffer and leave the source empty.
+ */
+
+   Queue(const Queue & src);
+   Queue & operator=(const Queue & src);
+   Queue(Queue && src);
+   Queue & operator=(Queue && src);
 
 };
 
@@ -161,44 +204,46 @@ extern void error(std::string msg);
  * Implementation notes: Queue data structure
  * ------------------------------------------
  * The array-based queue stores the elements in successive index
- * positions in a vector, just as a stack does.  What makes the
+ * positions in an array, just as a stack does.  What makes the
  * queue structure more complex is the need to avoid shifting
  * elements as the queue expands and contracts.  In the array
- * model, this goal is achieved by keeping track of both the
- * head and tail indices.  The tail index increases by one each
- * time an element is enqueued, and the head index increases by
- * one each time an element is dequeued.  Each index therefore
- * marches toward the end of the allocated vector and will
- * eventually reach the end.  Rather than allocate new memory,
- * this implementation lets each index wrap around back to the
- * beginning as if the ends of the array of elements were joined
+ * model, this goal is achieved by keeping track of the index of
+ * the head and the number of elements; the tail lies count slots
+ * past the head.  Each index marches toward the end of the array
+ * and will eventually reach the end.  Rather than allocate new
+ * memory, this implementation lets each index wrap around back to
+ * the beginning as if the ends of the array of elements were joined
  * to form a circle.  This representation is called a ring buffer.
+ *
+ * The capacity is always a power of two, so an index wraps with a
+ * mask rather than a division.  As in the Vector class, the array is
+ * raw storage: only the slots holding queued values are constructed,
+ * and values are moved into and out of the ring rather than copied.
  */
 
-const int INITIAL_CAPACITY = 10;
-
 /*
  * Implementation notes: Queue constructor
  * ---------------------------------------
- * The constructor must allocate the array storage for the queue
- * elements and initialize the fields of the object.
+ * The constructor leaves the queue without storage; the ring buffer
+ * is allocated by the first enqueue.
  */
 
 template <typename ValueType>
 Queue<ValueType>::Queue() {
-   clear();
+   elements = NULL;
+   capacity = head = count = 0;
 }
 
 /*
  * Implementation notes: ~Queue destructor
  * ---------------------------------------
- * All of the dynamic memory is allocated in the Vector class,
- * so no work is required at this level.
+ * The destructor destroys the queued values and frees the array.
  */
 
 template <typename ValueType>
 Queue<ValueType>::~Queue() {
-   /* Empty */
+   destroyAll();
+   release(elements);
 }
 
 template <typename ValueType>
@@ -213,33 +258,43 @@ bool Queue<ValueType>::isEmpty() const {
 
 template <typename ValueType>
 void Queue<ValueType>::clear() {
-   capacity = INITIAL_CAPACITY;
-   ringBuffer = Vector<ValueType>(capacity);
-   head = 0;
-   tail = 0;
-   count = 0;
+   destroyAll();
+   release(elements);
+   elements = NULL;
+   capacity = head = count = 0;
 }
 
 template <typename ValueType>
 void Queue<ValueType>::enqueue(ValueType value) {
-   if (count >= capacity - 1) expandRingBufferCapacity();
-   ringBuffer[tail] = value;
-   tail = (tail + 1) % capacity;
+   if (count == capacity) expandRingBufferCapacity();
+   new (elements + slotIndex(count)) ValueType(std::move(value));
    count++;
 }
 
+template <typename ValueType>
+void Queue<ValueType>::reserve(int n) {
+   if (n <= capacity) return;
+   int newCapacity = (capacity == 0) ? INITIAL_CAPACITY : capacity;
+   while (newCapacity < n) {
+      newCapacity *= 2;
+   }
+   reallocate(newCapacity);
+}
+
 /*
  * Implementation notes: dequeue, peek
  * -----------------------------------
  * These methods must check for an empty queue and report an error
- * if there is no first element.
+ * if there is no first element.  The dequeue method moves the value
+ * out of its slot before destroying it.
  */
 
 template <typename ValueType>
 ValueType Queue<ValueType>::dequeue() {
    if (count == 0) error("dequeue: Attempting to dequeue an empty queue");
-   ValueType result = ringBuffer[head];
-   head = (head + 1) % capacity;
+   ValueType result(std::move(elements[head]));
+   elements[head].~ValueType();
+   head = slotIndex(1);
    count--;
    return result;
 }
@@ -247,39 +302,132 @@ ValueType Queue<ValueType>::dequeue() {
 template <typename ValueType>
 ValueType Queue<ValueType>::peek() const {
    if (count == 0) error("peek: Attempting to peek at an empty queue");
-   return ringBuffer.get(head);
+   return elements[head];
 }
 
 template <typename ValueType>
 ValueType & Queue<ValueType>::front() {
    if (count == 0) error("front: Attempting to read front of an empty queue");
-   return ringBuffer[head];
+   return elements[head];
 }
 
 template <typename ValueType>
 ValueType & Queue<ValueType>::back() {
    if (count == 0) error("back: Attempting to read back of an empty queue");
-   return ringBuffer[(tail + capacity - 1) % capacity];
+   return elements[slotIndex(count - 1)];
 }
 
 /*
  * Implementation notes: expandRingBufferCapacity
  * ----------------------------------------------
- * This private method doubles the capacity of the ringBuffer vector.
- * Note that this implementation also shifts all the elements back to
- * the beginning of the vector.
+ * This private method doubles the capacity of the ring buffer.  The
+ * values occupy at most two runs of the old array, from the head to
+ * the end and from the start to the tail; reallocate moves each run
+ * into place with moveElements, so the values start at index 0 of
+ * the new array.  Trivially copyable values are moved with memcpy.
  */
 
 template <typename ValueType>
 void Queue<ValueType>::expandRingBufferCapacity() {
-   Vector<ValueType> copy = ringBuffer;
-   ringBuffer = Vector<ValueType>(2 * capacity);
+   reallocate((capacity == 0) ? INITIAL_CAPACITY : 2 * capacity);
+}
+
+template <typename ValueType>
+void Queue<ValueType>::reallocate(int newCapacity) {
+   ValueType *array = allocate(newCapacity);
+   int firstRun = (count < capacity - head) ? count : capacity - head;
+   moveElements(array, elements + head, firstRun);
+   moveElements(array + firstRun, elements, count - firstRun);
+   release(elements);
+   elements = array;
+   capacity = newCapacity;
+   head = 0;
+}
+
+template <typename ValueType>
+ValueType *Queue<ValueType>::allocate(int n) {
+   return static_cast<ValueType *>(::operator new(n * sizeof(ValueType)));
+}
+
+template <typename ValueType>
+void Queue<ValueType>::release(ValueType *array) {
+   if (array != NULL) ::operator delete(array);
+}
+
+template <typename ValueType>
+void Queue<ValueType>::moveElements(ValueType *dst, ValueType *src, int n) {
+   if (n <= 0) return;
+   if (std::is_trivially_copyable<ValueType>::value) {
+      memcpy((void *) dst, (const void *) src, n * sizeof(ValueType));
+   } else {
+      for (int i = 0; i < n; i++) {
+         new (dst + i) ValueType(std::move(src[i]));
+         src[i].~ValueType();
+      }
+   }
+}
+
+template <typename ValueType>
+void Queue<ValueType>::destroyAll() {
+   if (std::is_trivially_destructible<ValueType>::value) return;
    for (int i = 0; i < count; i++) {
-      ringBuffer[i] = copy[(head + i) % capacity];
+      elements[slotIndex(i)].~ValueType();
    }
+}
+
+/*
+ * Implementation notes: copy constructor and assignment operator
+ * --------------------------------------------------------------
+ * A copy gets a ring buffer of the same capacity with the values
+ * starting at index 0.
+ */
+
+template <typename ValueType>
+Queue<ValueType>::Queue(const Queue & src) {
+   deepCopy(src);
+}
+
+template <typename ValueType>
+Queue<ValueType> & Queue<ValueType>::operator=(const Queue & src) {
+   if (this != &src) {
+      clear();
+      deepCopy(src);
+   }
+   return *this;
+}
+
+template <typename ValueType>
+Queue<ValueType>::Queue(Queue && src) {
+   elements = src.elements;
+   capacity = src.capacity;
+   head = src.head;
+   count = src.count;
+   src.elements = NULL;
+   src.capacity = src.head = src.count = 0;
+}
+
+template <typename ValueType>
+Queue<ValueType> & Queue<ValueType>::operator=(Queue && src) {
+   if (this != &src) {
+      clear();
+      elements = src.elements;
+      capacity = src.capacity;
+      head = src.head;
+      count = src.count;
+      src.elements = NULL;
+      src.capacity = src.head = src.count = 0;
+   }
+   return *this;
+}
+
+template <typename ValueType>
+void Queue<ValueType>::deepCopy(const Queue & src) {
+   elements = (src.capacity == 0) ? NULL : allocate(src.capacity);
+   capacity = src.capacity;
    head = 0;
-   tail = count;
-   capacity *= 2;
+   for (count = 0; count < src.count; count++) {
+      new (elements + count) ValueType(src.elements[src.slotIndex(count)]);
+   }
 }
 
 template <typename ValueType>
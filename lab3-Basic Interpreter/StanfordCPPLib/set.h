@@ -295,8 +295,8 @@ public:
 /* Extended constructors */
 
    template <typename CompareType>
-   explicit Set(CompareType cmp) : map(Map<ValueType,bool>(cmp)) {
-      /* Empty */
+   explicit Set(CompareType cmp) : map(cmp) {
+      removeFlag = false;
    }
 
    Set & operator,(const ValueType & value) {
@@ -316,7 +316,15 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator : public std::iterator<std::input_iterator_tag,ValueType> {
+   class iterator {
+
+   public:
+
+      typedef std::input_iterator_tag iterator_category;
+      typedef ValueType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef ValueType *pointer;
+      typedef ValueType & reference;
 
    private:
 
@@ -332,10 +340,6 @@ public:
          /* Empty */
       }
 
-      iterator(const iterator & it) {
-         mapit = it.mapit;
-      }
-
       iterator & operator++() {
          ++mapit;
          return *this;
@@ -347,20 +351,20 @@ public:
          return copy;
       }
 
-      bool operator==(const iterator & rhs) {
+      bool operator==(const iterator & rhs) const {
          return mapit == rhs.mapit;
       }
 
-      bool operator!=(const iterator & rhs) {
+      bool operator!=(const iterator & rhs) const {
          return !(*this == rhs);
       }
 
-      ValueType operator*() {
+      const ValueType & operator*() const {
          return *mapit;
       }
 
-      ValueType *operator->() {
-         return mapit;
+      const ValueType *operator->() const {
+         return mapit.operator->();
       }
    };
 
@@ -372,13 +376,126 @@ public:
       return iterator(map.end());
    }
 
+private:
+
+/*
+ * Implementation notes: MergeIterator
+ * -----------------------------------
+ * A MergeIterator walks the elements of two sets together in their
+ * common order and stops only on the elements that belong to the union,
+ * intersection or difference of the sets.  Each element is therefore
+ * compared once, and the result comes out already sorted, which lets
+ * Map::buildFromKeys build the result tree in linear time.  The
+ * iterator points at the element stored in the operand's own node, so
+ * nothing is copied until the result node is made.  A default-
+ * constructed MergeIterator marks the end.  The walk is only correct
+ * when both sets use the same ordering, so merge falls back to looking
+ * up each element separately when Map::sameOrdering cannot show that.
+ */
+
+   enum MergeOp { UNION, INTERSECTION, DIFFERENCE };
+
+   class MergeIterator {
+
+   private:
+
+      iterator it1, end1;              /* Position in the first set   */
+      iterator it2, end2;              /* Position in the second set  */
+      const Map<ValueType,bool> *mp;   /* Map supplying the ordering  */
+      MergeOp op;                      /* The operation being applied */
+      const ValueType *current;        /* NULL at the end             */
+
+      void advance() {
+         current = NULL;
+         while (true) {
+            if (it2 == end2) {
+               if (it1 == end1 || op == INTERSECTION) return;
+               current = &*it1;
+               ++it1;
+               return;
+            }
+            if (it1 == end1) {
+               if (op != UNION) return;
+               current = &*it2;
+               ++it2;
+               return;
+            }
+            int sign = mp->compareKeys(*it1, *it2);
+            if (sign < 0) {
+               if (op != INTERSECTION) current = &*it1;
+               ++it1;
+            } else if (sign > 0) {
+               if (op == UNION) current = &*it2;
+               ++it2;
+            } else {
+               if (op != DIFFERENCE) current = &*it1;
+               ++it1;
+               ++it2;
+            }
+            if (current != NULL) return;
+         }
+      }
+
+   public:
+
+      MergeIterator() {
+         current = NULL;
+      }
+
+      MergeIterator(const Set & set1, const Set & set2, MergeOp op) {
+         it1 = set1.begin();
+         end1 = set1.end();
+         it2 = set2.begin();
+         end2 = set2.end();
+         mp = &set1.map;
+         this->op = op;
+         advance();
+      }
+
+      MergeIterator & operator++() {
+         advance();
+         return *this;
+      }
+
+      bool operator!=(const MergeIterator & rhs) const {
+         return current != rhs.current;
+      }
+
+      const ValueType & operator*() const {
+         return *current;
+      }
+   };
+
+   Set merge(const Set & set2, MergeOp op) const {
+      Set set;
+      set.map.copyComparator(map);
+      if (map.sameOrdering(set2.map)) {
+         set.map.buildFromKeys(MergeIterator(*this, set2, op),
+                               MergeIterator(), true);
+      } else if (op == INTERSECTION) {
+         for (const ValueType & value : *this) {
+            if (set2.map.containsKey(value)) set.map.put(value, true);
+         }
+      } else {
+         set.map = map;
+         for (const ValueType & value : set2) {
+            if (op == UNION) {
+               set.map.put(value, true);
+            } else {
+               set.map.remove(value);
+            }
+         }
+      }
+      return set;
+   }
+
 };
 
 extern void error(std::string msg);
 
 template <typename ValueType>
 Set<ValueType>::Set() {
-   /* Empty */
+   removeFlag = false;
 }
 
 template <typename ValueType>
@@ -421,13 +538,34 @@ void Set<ValueType>::clear() {
    map.clear();
 }
 
+/*
+ * Implementation notes: isSubsetOf
+ * --------------------------------
+ * When the sets use the same ordering, both are walked together in
+ * order.  Each element of this set must be matched before the walk
+ * through set2 passes it, so the test takes time proportional to the
+ * sizes of the two sets.  Otherwise each element is looked up in set2.
+ */
+
 template <typename ValueType>
 bool Set<ValueType>::isSubsetOf(const Set & set2) const {
-   iterator it = begin();
-   iterator end = this->end();
-   while (it != end) {
-      if (!set2.map.containsKey(*it)) return false;
-      ++it;
+   if (!map.sameOrdering(set2.map)) {
+      for (const ValueType & value : *this) {
+         if (!set2.map.containsKey(value)) return false;
+      }
+      return true;
+   }
+   if (size() > set2.size()) return false;
+   iterator it1 = begin();
+   iterator end1 = this->end();
+   iterator it2 = set2.begin();
+   iterator end2 = set2.end();
+   while (it1 != end1) {
+      if (it2 == end2) return false;
+      int sign = map.compareKeys(*it1, *it2);
+      if (sign < 0) return false;
+      if (sign == 0) ++it1;
+      ++it2;
    }
    return true;
 }
@@ -436,7 +574,12 @@ bool Set<ValueType>::isSubsetOf(const Set & set2) const {
  * Implementation notes: set operators
  * -----------------------------------
  * The implementations for the set operators use iteration to walk
- * over the elements in one or both sets.
+ * over the elements in one or both sets.  Union, intersection and
+ * difference merge the two sorted sets and build the result tree
+ * from the merged elements in one pass.  The compound assignment
+ * forms build the result the same way and then move it into place.
+ * When the sets use different orderings, merge instead looks up each
+ * element on its own, as isSubsetOf does.
  */
 
 template <typename ValueType>
@@ -460,11 +603,7 @@ bool Set<ValueType>::operator!=(const Set & set2) const {
 
 template <typename ValueType>
 Set<ValueType> Set<ValueType>::operator+(const Set & set2) const {
-   Set<ValueType> set = *this;
-   foreach (ValueType value in set2) {
-      set.add(value);
-   }
-   return set;
+   return merge(set2, UNION);
 }
 
 template <typename ValueType>
@@ -476,21 +615,12 @@ Set<ValueType> Set<ValueType>::operator+(const ValueType & element) const {
 
 template <typename ValueType>
 Set<ValueType> Set<ValueType>::operator*(const Set & set2) const {
-   Set<ValueType> set = *this;
-   set.clear();
-   foreach (ValueType value in *this) {
-      if (set2.contains(value)) set.add(value);
-   }
-   return set;
+   return merge(set2, INTERSECTION);
 }
 
 template <typename ValueType>
 Set<ValueType> Set<ValueType>::operator-(const Set & set2) const {
-   Set<ValueType> set = *this;
-   foreach (ValueType value in set2) {
-      set.remove(value);
-   }
-   return set;
+   return merge(set2, DIFFERENCE);
 }
 
 template <typename ValueType>
@@ -502,8 +632,9 @@ Set<ValueType> Set<ValueType>::operator-(const ValueType & element) const {
 
 template <typename ValueType>
 Set<ValueType> & Set<ValueType>::operator+=(const Set & set2) {
-   foreach (ValueType value in set2) {
-      this->add(value);
+   if (!set2.isEmpty()) {
+      Set<ValueType> set = merge(set2, UNION);
+      map = std::move(set.map);
    }
    return *this;
 }
@@ -517,24 +648,18 @@ Set<ValueType> & Set<ValueType>::operator+=(const ValueType & value) {
 
 template <typename ValueType>
 Set<ValueType> & Set<ValueType>::operator*=(const Set & set2) {
-   Vector<ValueType> toRemove;
-   foreach (ValueType value in *this) {
-      if (!set2.map.containsKey(value)) toRemove.add(value);
-   }
-   foreach (ValueType value in toRemove) {
-      this->remove(value);
+   if (this != &set2) {
+      Set<ValueType> set = merge(set2, INTERSECTION);
+      map = std::move(set.map);
    }
    return *this;
 }
 
 template <typename ValueType>
 Set<ValueType> & Set<ValueType>::operator-=(const Set & set2) {
-   Vector<ValueType> toRemove;
-   foreach (ValueType value in *this) {
-      if (set2.map.containsKey(value)) toRemove.add(value);
-   }
-   foreach (ValueType value in toRemove) {
-      this->remove(value);
+   if (!set2.isEmpty()) {
+      Set<ValueType> set = merge(set2, DIFFERENCE);
+      map = std::move(set.map);
    }
    return *this;
 }
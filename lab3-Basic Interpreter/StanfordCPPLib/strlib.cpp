@@ -5,6 +5,7 @@
  */
 
 #include <cctype>
+#include <charconv>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -17,25 +18,39 @@ using namespace std;
 /*
  * Implementation notes: numeric conversion
  * ----------------------------------------
- * These functions use the <sstream> library to perform the conversion.
+ * The integer conversions use std::to_chars and std::from_chars, which
+ * work directly on character buffers and never allocate a stream.
+ * from_chars also reports values that overflow an int, which the stream
+ * version silently clamped.  The floating-point conversions still use
+ * the <sstream> library.
  */
 
 string integerToString(int n) {
-   ostringstream stream;
-   stream << n;
-   return stream.str();
+   char buffer[16];
+   to_chars_result result = to_chars(buffer, buffer + sizeof buffer, n);
+   return string(buffer, result.ptr);
 }
 
-int stringToInteger(string str) {
-   istringstream stream(str);
+int stringToInteger(const string & str) {
    int value;
-   stream >> value >> ws;
-   if (stream.fail() || !stream.eof()) {
+   if (!tryStringToInteger(str, value)) {
       error("stringToInteger: Illegal integer format (" + str + ")");
    }
    return value;
 }
 
+bool tryStringToInteger(const string & str, int & value) {
+   return tryStringToInteger(str.data(), str.data() + str.length(), value);
+}
+
+bool tryStringToInteger(const char *start, const char *finish, int & value) {
+   while (start < finish && isspace((unsigned char) *start)) start++;
+   while (finish > start && isspace((unsigned char) finish[-1])) finish--;
+   if (start < finish && *start == '+') start++;
+   from_chars_result result = from_chars(start, finish, value);
+   return result.ec == errc() && result.ptr == finish;
+}
+
 string realToString(double d) {
    ostringstream stream;
    stream << uppercase << d;
@@ -32,7 +32,24 @@ std::string integerToString(int n);
  * appropriate message.
  */
 
-int stringToInteger(std::string str);
+int stringToInteger(const std::string & str);
+
+/*
+ * Function: tryStringToInteger
+ * Usage: if (tryStringToInteger(str, n)) ...
+ * ------------------------------------------
+ * Converts a string of digits into an integer in the same way as
+ * <code>stringToInteger</code>, but reports failure by returning
+ * <code>false</code> instead of calling <code>error</code>.  Strings
+ * whose value does not fit in an <code>int</code> are rejected.  On
+ * failure the contents of <code>value</code> are unspecified.  The
+ * second form converts the characters from <code>start</code> up to
+ * but not including <code>finish</code>, which lets a caller convert
+ * part of a larger buffer without copying it into a string.
+ */
+
+bool tryStringToInteger(const std::string & str, int & value);
+bool tryStringToInteger(const char *start, const char *finish, int & value);
 
 /*
  * Function: realToString
@@ -28,20 +28,37 @@ TokenScanner::TokenScanner(istream & infile) {
 }
 
 TokenScanner::~TokenScanner() {
+   discardSavedTokens();
    if (stringInputFlag) delete isp;
 }
 
+/*
+ * Implementation notes: setInput
+ * ------------------------------
+ * When the scanner is already reading from a string, the existing
+ * istringstream is rewound onto the new text instead of being replaced,
+ * which lets a client that scans many short lines reuse one scanner
+ * without allocating a fresh stream for each of them.
+ */
+
 void TokenScanner::setInput(string str) {
-   stringInputFlag = true;
+   discardSavedTokens();
    buffer = str;
-   isp = new istringstream(buffer);
-   savedTokens = NULL;
+   if (stringInputFlag) {
+      istringstream *stream = (istringstream *) isp;
+      stream->str(buffer);
+      stream->clear();
+   } else {
+      isp = new istringstream(buffer);
+   }
+   stringInputFlag = true;
 }
 
 void TokenScanner::setInput(istream & infile) {
+   discardSavedTokens();
+   if (stringInputFlag) delete isp;
    stringInputFlag = false;
    isp = &infile;
-   savedTokens = NULL;
 }
 
 bool TokenScanner::hasMoreTokens() {
@@ -244,9 +261,26 @@ void TokenScanner::initScanner() {
    ignoreCommentsFlag = false;
    scanNumbersFlag = false;
    scanStringsFlag = false;
+   stringInputFlag = false;
+   isp = NULL;
+   savedTokens = NULL;
    operators = NULL;
 }
 
+/*
+ * Implementation notes: discardSavedTokens
+ * ----------------------------------------
+ * Frees any tokens pushed back by saveToken that were never read.
+ */
+
+void TokenScanner::discardSavedTokens() {
+   while (savedTokens != NULL) {
+      StringCell *cp = savedTokens;
+      savedTokens = cp->link;
+      delete cp;
+   }
+}
+
 /*
  * Implementation notes: skipSpaces
  * --------------------------------
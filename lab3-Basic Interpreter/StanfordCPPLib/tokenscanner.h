@@ -75,7 +75,10 @@ public:
  *        scanner.setInput(infile);
  * --------------------------------
  * Sets the token stream for this scanner to the specified string or
- * input stream.  Any previous token stream is discarded.
+ * input stream.  Any previous token stream is discarded, along with
+ * any tokens saved from it.  The scanner's configuration (whitespace,
+ * number and operator settings) is preserved, so a single scanner
+ * can be reused for any number of inputs.
  */
 
    void setInput(std::string str);
@@ -334,6 +337,7 @@ private:
 /* Private method prototypes */
 
    void initScanner();
+   void discardSavedTokens();
    void skipSpaces();
    std::string scanWord();
    std::string scanNumber();
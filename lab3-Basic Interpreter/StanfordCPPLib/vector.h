@@ -8,10 +8,14 @@
 #ifndef _vector_h
 #define _vector_h
 
+#include <cstring>
 #include <iterator>
 #include <iostream>
+#include <new>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include "foreach.h"
 #include "strlib.h"
 
@@ -100,6 +104,7 @@ public:
  */
 
    void set(int index, const ValueType & value);
+   void set(int index, ValueType && value);
 
 /*
  * Method: insert
@@ -130,12 +135,48 @@ public:
  * ----------------------
  * Adds a new value to the end of this vector.  To ensure compatibility
  * with the <code>vector</code> class in the Standard Template Library,
- * this method is also called <code>push_back</code>.
+ * this method is also called <code>push_back</code>.  Like
+ * <code>insert</code>, it takes its argument by value and moves it into
+ * place, so a temporary is moved rather than copied.
  */
 
    void add(ValueType value);
    void push_back(ValueType value);
 
+/*
+ * Methods: emplace, emplace_back
+ * Usage: vec.emplace(index, args...);
+ *        ValueType & elem = vec.emplace_back(args...);
+ * ------------------------------------------------------
+ * Constructs a new element from the given constructor arguments
+ * directly in the vector's storage, either before the specified index
+ * or at the end.  The index is checked as for <code>insert</code>.
+ */
+
+   template <typename... ArgTypes>
+   void emplace(int index, ArgTypes && ... args);
+   template <typename... ArgTypes>
+   ValueType & emplace_back(ArgTypes && ... args);
+
+/*
+ * Method: reserve
+ * Usage: vec.reserve(n);
+ * ----------------------
+ * Makes sure that this vector can hold at least <code>n</code> elements
+ * without allocating more memory.
+ */
+
+   void reserve(int n);
+
+/*
+ * Method: shrink_to_fit
+ * Usage: vec.shrink_to_fit();
+ * ---------------------------
+ * Frees any memory this vector holds beyond what its elements need.
+ */
+
+   void shrink_to_fit();
+
 /*
  * Operator: []
  * Usage: vec[index]
@@ -229,7 +270,9 @@ private:
  * -------------------------------------------
  * The elements of the Vector are stored in a dynamic array of
  * the specified element type.  If the space in the array is ever
- * exhausted, the implementation doubles the array capacity.
+ * exhausted, the implementation doubles the array capacity.  The
+ * array is raw storage: only the first count slots hold constructed
+ * elements, and the rest are left uninitialized until they are used.
  */
 
 /* Instance variables */
@@ -240,7 +283,11 @@ private:
 
 /* Private methods */
 
-   void expandCapacity();
+   static ValueType *allocate(int n);
+   static void release(ValueType *array);
+   static void relocate(ValueType *dst, ValueType *src, int n);
+   void reallocate(int newCapacity);
+   void destroyAll();
    void deepCopy(const Vector & src);
 
 /*
@@ -259,11 +306,15 @@ public:
  * --------------------
  * This copy constructor and operator= are defined to make a deep copy,
  * making it possible to pass or return vectors by value and assign
- * from one vector to another.
+ * from one vector to another.  The move constructor and move
+ * assignment take over the array of a vector that is about to be
+ * discarded, leaving it empty, and so copy nothing.
  */
 
    Vector(const Vector & src);
    Vector & operator=(const Vector & src);
+   Vector(Vector && src);
+   Vector & operator=(Vector && src);
 
 /*
  * Operator: ,
@@ -282,8 +333,15 @@ public:
  * corresponding STL classes.
  */
 
-   class iterator :
-      public std::iterator<std::random_access_iterator_tag, ValueType> {
+   class iterator {
+
+   public:
+
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef ValueType value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef ValueType *pointer;
+      typedef ValueType & reference;
 
    private:
       const Vector *vp;
@@ -427,16 +485,17 @@ Vector<ValueType>::Vector() {
 
 template <typename ValueType>
 Vector<ValueType>::Vector(int n, ValueType value) {
-   count = capacity = n;
-   elements = (n == 0) ? NULL : new ValueType[n];
-   for (int i = 0; i < n; i++) {
-      elements[i] = value;
+   elements = allocate(n);
+   capacity = n;
+   for (count = 0; count < n; count++) {
+      new (elements + count) ValueType(value);
    }
 }
 
 template <typename ValueType>
 Vector<ValueType>::~Vector() {
-   if (elements != NULL) delete[] elements;
+   destroyAll();
+   release(elements);
 }
 
 /*
@@ -458,7 +517,8 @@ bool Vector<ValueType>::isEmpty() const {
 
 template <typename ValueType>
 void Vector<ValueType>::clear() {
-   if (elements != NULL) delete[] elements;
+   destroyAll();
+   release(elements);
    count = capacity = 0;
    elements = NULL;
 }
@@ -475,44 +535,93 @@ void Vector<ValueType>::set(int index, const ValueType & value) {
    elements[index] = value;
 }
 
+template <typename ValueType>
+void Vector<ValueType>::set(int index, ValueType && value) {
+   if (index < 0 || index >= count) error("set: index out of range");
+   elements[index] = std::move(value);
+}
+
 /*
- * Implementation notes: insert, remove, add
- * -----------------------------------------
+ * Implementation notes: insert, remove, add, emplace
+ * --------------------------------------------------
  * These methods must shift the existing elements in the array to
  * make room for a new element or to close up the space left by a
- * deleted one.
+ * deleted one.  The elements are shifted with relocate, which moves
+ * them rather than copying them.  All of the insertion methods end up
+ * in emplace.  When the array is full, emplace builds the new element
+ * in the new array before moving the old elements across, and when it
+ * is not, it builds the element before shifting, so the arguments may
+ * safely refer to elements of this vector.
  */
 
 template <typename ValueType>
-void Vector<ValueType>::insert(int index, ValueType value) {
-   if (count == capacity) expandCapacity();
+template <typename... ArgTypes>
+void Vector<ValueType>::emplace(int index, ArgTypes && ... args) {
    if (index < 0 || index > count) {
       error("insert: index out of range");
    }
-   for (int i = count; i > index; i--) {
-      elements[i] = elements[i - 1];
+   if (count == capacity) {
+      int newCapacity = max(1, capacity * 2);
+      ValueType *array = allocate(newCapacity);
+      try {
+         new (array + index) ValueType(std::forward<ArgTypes>(args)...);
+      } catch (...) {
+         release(array);
+         throw;
+      }
+      relocate(array, elements, index);
+      relocate(array + index + 1, elements + index, count - index);
+      release(elements);
+      elements = array;
+      capacity = newCapacity;
+   } else if (index == count) {
+      new (elements + count) ValueType(std::forward<ArgTypes>(args)...);
+   } else {
+      ValueType value(std::forward<ArgTypes>(args)...);
+      relocate(elements + index + 1, elements + index, count - index);
+      new (elements + index) ValueType(std::move(value));
    }
-   elements[index] = value;
    count++;
 }
 
+template <typename ValueType>
+template <typename... ArgTypes>
+ValueType & Vector<ValueType>::emplace_back(ArgTypes && ... args) {
+   emplace(count, std::forward<ArgTypes>(args)...);
+   return elements[count - 1];
+}
+
+template <typename ValueType>
+void Vector<ValueType>::insert(int index, ValueType value) {
+   emplace(index, std::move(value));
+}
+
 template <typename ValueType>
 void Vector<ValueType>::remove(int index) {
    if (index < 0 || index >= count) error("remove: index out of range");
-   for (int i = index; i < count - 1; i++) {
-      elements[i] = elements[i + 1];
-   }
+   elements[index].~ValueType();
+   relocate(elements + index, elements + index + 1, count - index - 1);
    count--;
 }
 
 template <typename ValueType>
 void Vector<ValueType>::add(ValueType value) {
-   insert(count, value);
+   emplace(count, std::move(value));
 }
 
 template <typename ValueType>
 void Vector<ValueType>::push_back(ValueType value) {
-   insert(count, value);
+   emplace(count, std::move(value));
+}
+
+template <typename ValueType>
+void Vector<ValueType>::reserve(int n) {
+   if (n > capacity) reallocate(n);
+}
+
+template <typename ValueType>
+void Vector<ValueType>::shrink_to_fit() {
+   if (count < capacity) reallocate(count);
 }
 
 /*
@@ -578,18 +687,48 @@ Vector<ValueType>::Vector(const Vector & src) {
 template <typename ValueType>
 Vector<ValueType> & Vector<ValueType>::operator=(const Vector & src) {
    if (this != &src) {
-      if (elements != NULL) delete[] elements;
+      clear();
       deepCopy(src);
    }
    return *this;
 }
 
+template <typename ValueType>
+Vector<ValueType>::Vector(Vector && src) {
+   elements = src.elements;
+   capacity = src.capacity;
+   count = src.count;
+   src.elements = NULL;
+   src.count = src.capacity = 0;
+}
+
+template <typename ValueType>
+Vector<ValueType> & Vector<ValueType>::operator=(Vector && src) {
+   if (this != &src) {
+      clear();
+      elements = src.elements;
+      capacity = src.capacity;
+      count = src.count;
+      src.elements = NULL;
+      src.count = src.capacity = 0;
+   }
+   return *this;
+}
+
 template <typename ValueType>
 void Vector<ValueType>::deepCopy(const Vector & src) {
-   count = capacity = src.count;
-   elements = (capacity == 0) ? NULL : new ValueType[capacity];
-   for (int i = 0; i < count; i++) {
-      elements[i] = src.elements[i];
+   elements = allocate(src.count);
+   capacity = src.count;
+   if (std::is_trivially_copyable<ValueType>::value) {
+      if (src.count > 0) {
+         memcpy((void *) elements, (const void *) src.elements,
+                src.count * sizeof(ValueType));
+      }
+      count = src.count;
+   } else {
+      for (count = 0; count < src.count; count++) {
+         new (elements + count) ValueType(src.elements[count]);
+      }
    }
 }
 
@@ -637,21 +776,61 @@ void Vector<ValueType>::mapAll(FunctorType fn) const {
 }
 
 /*
- * Implementation notes: expandCapacity
- * ------------------------------------
- * This function doubles the array capacity, copies the old elements
- * into the new array, and then frees the old one.
+ * Implementation notes: storage management
+ * ----------------------------------------
+ * The array is obtained from ::operator new, so no element is
+ * constructed until it is added.  relocate moves n elements from src
+ * to uninitialized storage at dst, leaving the source slots
+ * uninitialized; the ranges may overlap, so it also serves to shift
+ * elements within the array.  Elements of trivially copyable types are
+ * relocated with a single memmove, and all others are move-constructed
+ * at their new place and then destroyed at the old one.
  */
 
 template <typename ValueType>
-void Vector<ValueType>::expandCapacity() {
-   capacity = max(1, capacity * 2);
-   ValueType *array = new ValueType[capacity];
-   for (int i = 0; i < count; i++) {
-      array[i] = elements[i];
+ValueType *Vector<ValueType>::allocate(int n) {
+   if (n == 0) return NULL;
+   return static_cast<ValueType *>(::operator new(n * sizeof(ValueType)));
+}
+
+template <typename ValueType>
+void Vector<ValueType>::release(ValueType *array) {
+   if (array != NULL) ::operator delete(array);
+}
+
+template <typename ValueType>
+void Vector<ValueType>::relocate(ValueType *dst, ValueType *src, int n) {
+   if (n <= 0 || dst == src) return;
+   if (std::is_trivially_copyable<ValueType>::value) {
+      memmove((void *) dst, (const void *) src, n * sizeof(ValueType));
+   } else if (dst < src) {
+      for (int i = 0; i < n; i++) {
+         new (dst + i) ValueType(std::move(src[i]));
+         src[i].~ValueType();
+      }
+   } else {
+      for (int i = n - 1; i >= 0; i--) {
+         new (dst + i) ValueType(std::move(src[i]));
+         src[i].~ValueType();
+      }
    }
-   if (elements != NULL) delete[] elements;
+}
+
+template <typename ValueType>
+void Vector<ValueType>::reallocate(int newCapacity) {
+   ValueType *array = allocate(newCapacity);
+   relocate(array, elements, count);
+   release(elements);
    elements = array;
+   capacity = newCapacity;
+}
+
+template <typename ValueType>
+void Vector<ValueType>::destroyAll() {
+   for (int i = 0; i < count; i++) {
+      elements[i].~ValueType();
+   }
+   count = 0;
 }
 
 /*
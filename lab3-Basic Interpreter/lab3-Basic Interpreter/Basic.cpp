@@ -10,10 +10,15 @@
 
 #include <cctype>
 #include <iostream>
+#include <memory>
 #include <string>
+#include "compiled.h"
 #include "exp.h"
+#include "memusage.h"
 #include "parser.h"
 #include "program.h"
+#include "sourcefile.h"
+#include "trace.h"
 #include "../StanfordCPPLib/error.h"
 #include "../StanfordCPPLib/tokenscanner.h"
 
@@ -23,29 +28,70 @@ using namespace std;
 
 /* Function prototypes */
 
-void processLine(string line, Program & program, EvalState & state);
-void run(Program & program, EvalState & state);
+void processLine(const string & line, Program & program, EvalState & state,
+                 ParseContext & context);
+void run(Program & program, EvalState & state, int startLine = -1);
+string readFileName(TokenScanner & scanner, const string & line);
+int finishSession(EvalState & state);
+
+/* Trace options set by --record and --replay */
+
+static string traceFile;
+static bool replaying = false;
 
 /* Main program */
 
-int main() {
+int main(int argc, char *argv[]) {
    EvalState state;
    Program program;
+   ParseContext context;
+   InputFeed feed;
+   ExecutionTrace trace;
+   string line;
+   state.setInputFeed(&feed);
+   for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      try {
+         if (arg == "--input" && i + 1 < argc) {
+            feed.loadFile(argv[++i]);
+         } else if (arg == "--record" && i + 1 < argc) {
+            traceFile = argv[++i];
+            replaying = false;
+         } else if (arg == "--replay" && i + 1 < argc) {
+            traceFile = argv[++i];
+            replaying = true;
+            trace.load(traceFile);
+            feed.loadValues(trace.getExpectedInputs());
+         } else if (arg == "--mem-limit" && i + 1 < argc) {
+            int limit = stringToInteger(argv[++i]);
+            if (limit < 0) error("--mem-limit: limit must not be negative");
+            setMemoryLimit(limit);
+         } else {
+            error("usage: " + string(argv[0])
+                  + " [--input file] [--record trace | --replay trace]"
+                  + " [--mem-limit bytes]");
+         }
+      } catch (ErrorException & ex) {
+         cerr << "Error: " << ex.getMessage() << endl;
+         return 1;
+      }
+   }
+   if (traceFile != "") state.setTrace(&trace);
    //cout << "Stub implementation of BASIC" << endl;
-   while (true) {
+   while (getline(cin, line)) {
       try {
-         processLine(getLine(), program, state);
+         processLine(line, program, state, context);
       } catch (ErrorException & ex) {
          cerr << "Error: " << ex.getMessage() << endl;
       }
    }
-   return 0;
+   return finishSession(state);
 }
 
 /*
  * Function: processLine
- * Usage: processLine(line, program, state);
- * -----------------------------------------
+ * Usage: processLine(line, program, state, context);
+ * --------------------------------------------------
  * Processes a single line entered by the user.  In this version,
  * the implementation does exactly what the interpreter program
  * does in Chapter 19: read a line, parse it as an expression,
@@ -55,33 +101,68 @@ int main() {
  * or one of the BASIC commands, such as LIST or RUN.
  */
 
-void processLine(string line, Program & program, EvalState & state) {
-   TokenScanner scanner;
-   scanner.ignoreWhitespace();
-   scanner.scanNumbers();
-   scanner.setInput(line);
+void processLine(const string & line, Program & program, EvalState & state,
+                 ParseContext & context) {
+   TokenScanner & scanner = context.reset(line);
    string test = scanner.nextToken();
+   if (test == "") return;
 
    //command QUIT
    //--------------------------------------------------
    if (test == "QUIT")
-	   exit(0);
+	   exit(finishSession(state));
 
    //command RUN
    //--------------------------------------------------
    if (test == "RUN") {
-	   run(program, state);
+	   string start = scanner.nextToken();
+	   if (start == "")
+		   run(program, state);
+	   else
+		   run(program, state, stringToInteger(start));
 	   return;
    }
 
    //command LIST
    //--------------------------------------------------
    if (test == "LIST") {
-	   int begin = program.getFirstLineNumber();
-	   while (begin != -1) {
-		   cout << program.getSourceLine(begin) << endl;
-		   begin = program.getNextLineNumber(begin);
+	   program.listSource(cout);
+	   return;
+   }
+
+   //command RENUM
+   //--------------------------------------------------
+   if (test == "RENUM") {
+	   int start = 10;
+	   int step = 10;
+	   if (scanner.hasMoreTokens())
+		   start = stringToInteger(scanner.nextToken());
+	   if (scanner.hasMoreTokens()) {
+		   scanner.verifyToken(",");
+		   step = stringToInteger(scanner.nextToken());
+	   }
+	   program.renumber(start, step);
+	   return;
+   }
+
+   //command MEM
+   //--------------------------------------------------
+   if (test == "MEM") {
+	   if (scanner.hasMoreTokens()) {
+		   scanner.verifyToken("LIMIT");
+		   setMemoryLimit(stringToInteger(scanner.nextToken()));
+		   return;
+	   }
+	   for (int i = 0; i <= MEM_CATEGORIES; i++) {
+		   MemoryCategory category = MemoryCategory(i);
+		   const char *name = (category == MEM_CATEGORIES) ? "TOTAL" : getMemoryCategoryName(category);
+		   cout << name << " " << getMemoryUsed(category) << endl;
 	   }
+	   cout << "LIMIT ";
+	   if (getMemoryLimit() == 0)
+		   cout << "NONE" << endl;
+	   else
+		   cout << getMemoryLimit() << endl;
 	   return;
    }
 
@@ -93,6 +174,53 @@ void processLine(string line, Program & program, EvalState & state) {
 	   return;
    }
 
+   //command INPUTS
+   //--------------------------------------------------
+   if (test == "INPUTS") {
+	   InputFeed *feed = state.getInputFeed();
+	   if (feed == NULL)
+		   error("INPUTS: no input feed");
+	   if (scanner.hasMoreTokens())
+		   feed->loadFile(readFileName(scanner, line));
+	   else
+		   feed->clear();
+	   return;
+   }
+
+   //command SNAPSHOT / RESTORE
+   //--------------------------------------------------
+   if (test == "SNAPSHOT" || test == "RESTORE") {
+	   string name = scanner.nextToken();
+	   if (scanner.getTokenType(name) != WORD)
+		   error("expected a snapshot name after " + test);
+	   if (test == "SNAPSHOT")
+		   state.saveSnapshot(name);
+	   else
+		   state.restoreSnapshot(name);
+	   return;
+   }
+
+   //command SAVE / LOAD / MERGE, with or without COMPILED
+   //--------------------------------------------------
+   if (test == "SAVE" || test == "LOAD" || test == "MERGE") {
+	   string token = scanner.nextToken();
+	   bool compiled = (token == "COMPILED" && test != "MERGE");
+	   if (!compiled)
+		   scanner.saveToken(token);
+	   string filename = readFileName(scanner, line);
+	   if (test == "SAVE" && compiled)
+		   saveCompiledProgram(program, filename);
+	   else if (test == "SAVE")
+		   saveSourceFile(program, filename);
+	   else if (test == "LOAD" && compiled)
+		   loadCompiledProgram(program, filename);
+	   else if (test == "LOAD")
+		   loadSourceFile(program, filename, context);
+	   else
+		   mergeSourceFile(program, filename, context);
+	   return;
+   }
+
    //command HELP
    //--------------------------------------------------
    if (test == "HELP") {
@@ -105,6 +233,19 @@ void processLine(string line, Program & program, EvalState & state) {
 		   << "GOTO n" << endl
 		   << "IF exp cmp exp THEN n" << endl
 		   << "RUN\nLIST\nCLEAR\nQUIT\nHELP" << endl
+		   << "RUN n \t Run the program starting from line n." << endl
+		   << "MEM \t Show the bytes used by source, expressions, statements and variables." << endl
+		   << "MEM LIMIT n \t Report OUT OF MEMORY instead of using more than n bytes (0 for no limit)." << endl
+		   << "RENUM [start[,step]] \t Renumber the lines from start (default 10) by step (default 10)." << endl
+		   << "INPUTS file \t Take the values for INPUT from a file, without prompting." << endl
+		   << "INPUTS \t Go back to asking the user for INPUT values." << endl
+		   << "SNAPSHOT name \t Save the values of all variables under a name." << endl
+		   << "RESTORE name \t Set all variables back to a saved snapshot." << endl
+		   << "SAVE \"file\" \t Save the program as a text file." << endl
+		   << "LOAD \"file\" \t Replace the program with the lines in a text file." << endl
+		   << "MERGE \"file\" \t Add the lines in a text file to the program." << endl
+		   << "SAVE COMPILED file \t Save the parsed program as a binary image." << endl
+		   << "LOAD COMPILED file \t Replace the program with a saved binary image." << endl
 		   << "For example:" << endl
 		   << "10 REM Program to simulate a countdown" << endl
 		   << "20 LET T = 10" << endl
@@ -119,12 +260,16 @@ void processLine(string line, Program & program, EvalState & state) {
    //Program with Line Number
    //--------------------------------------------------
    if (scanner.getTokenType(test) == NUMBER) {
+	   int lineNumber = stringToInteger(test);
 	   if (!scanner.hasMoreTokens())
-		   program.removeSourceLine(stoi(test));
+		   program.removeSourceLine(lineNumber);
 	   else {
-		   program.addSourceLine(stoi(test), line);
-		   Statement *statement = parseState(scanner);
-		   program.setParsedStatement(stoi(test), statement);
+		   unique_ptr<Statement> statement(parseState(scanner));
+		   if (statement == NULL)
+			   error("illegal statement");
+		   program.addSourceLine(lineNumber, line);
+		   program.setParsedStatement(lineNumber, statement.get());
+		   statement.release();
 	   }
 	   return;
    }
@@ -132,50 +277,96 @@ void processLine(string line, Program & program, EvalState & state) {
    //Executed directly
    //--------------------------------------------------
    scanner.saveToken(test);
-   Statement *statement = parseState(scanner);
+   unique_ptr<Statement> statement(parseState(scanner));
+   if (statement == NULL)
+	   error("illegal statement");
    statement->execute(state);
-   delete statement;
 }
 
 /*
 * Function: run
 * Usage: run(program, state);
+*        run(program, state, startLine);
 * -----------------------------------------
 * Execute the run command, and it include the futher implementation
-* of control statement of GOTO as well as IF_THEN
+* of control statement of GOTO as well as IF_THEN.  The program is
+* linked first, so each step follows the next and target links of the
+* current line instead of looking up line numbers.  A jump to any other
+* line is found through the program's line-number index.  If startLine
+* is given, execution begins at that line instead of the first one.
 */
 
-void run(Program & program, EvalState & state) {
-	TokenScanner scanner;
-	scanner.ignoreWhitespace();
-	scanner.scanNumbers();
-	int begin = program.getFirstLineNumber();
-	while (begin != -1) {
-		Statement *stmt = program.getParsedStatement(begin);
-		stmt->execute(state);
-		begin = program.getNextLineNumber(begin);
-
-		//command GOTO
-		//--------------------------------------------------
-		if (state.isDefined("GOTO")) {
-			begin = state.getValue("GOTO");
-			state.eraseValue("GOTO");
-			if (program.getSourceLine(begin) == "") {
-				cout << "LINE NUMBER ERROR" << endl;
-				error("line number error");
-			}
+void run(Program & program, EvalState & state, int startLine) {
+	program.link();
+	state.takeJump();
+	ProgramLine *line = program.getFirstLine();
+	if (startLine != -1) {
+		line = program.getLine(startLine);
+		if (line == NULL) {
+			cout << "LINE NUMBER ERROR" << endl;
+			error("line number error");
 		}
+	}
+	while (line != NULL) {
+		line->stmt->execute(state);
+		ProgramLine *next = line->next;
 
-		//command IF_THEN
-		//---------------------------------------------------
-		if (state.isDefined("THEN")) {
-			begin = state.getValue("THEN");
-			state.eraseValue("THEN");
-			if (program.getSourceLine(begin) == "") {
+		//command GOTO and IF_THEN
+		//--------------------------------------------------
+		int jump = state.takeJump();
+		if (jump != -1) {
+			next = (jump == line->targetNumber) ? line->target : program.getLine(jump);
+			if (next == NULL) {
 				cout << "LINE NUMBER ERROR" << endl;
 				error("line number error");
 			}
 		}
+		line = next;
 	}
+}
 
+/*
+* Function: readFileName
+* Usage: string filename = readFileName(scanner, line);
+* -----------------------------------------
+* Returns the rest of the line after the scanner's current position as
+* a file name, with surrounding whitespace and double quotes removed.
+*/
+
+string readFileName(TokenScanner & scanner, const string & line) {
+	int pos = scanner.getPosition();
+	string filename = trim(line.substr(pos < 0 ? line.length() : pos));
+	if (filename.length() >= 2 && filename[0] == '"' && filename[filename.length() - 1] == '"')
+		filename = filename.substr(1, filename.length() - 2);
+	if (filename == "")
+		error("missing file name");
+	return filename;
+}
+
+/*
+* Function: finishSession
+* Usage: exit(finishSession(state));
+* -----------------------------------------
+* Ends a traced session and returns the exit status for the interpreter.
+* After --record, the trace is written to the trace file.  After --replay,
+* the output hash is compared with the recorded one and a mismatch gives
+* a status of 1.  Untraced sessions simply return 0.
+*/
+
+int finishSession(EvalState & state) {
+	ExecutionTrace *trace = state.getTrace();
+	if (trace == NULL)
+		return 0;
+	try {
+		if (!replaying) {
+			trace->save(traceFile);
+		} else if (!trace->matchesExpectedOutput()) {
+			cerr << "REPLAY MISMATCH: output differs from " << traceFile << endl;
+			return 1;
+		}
+	} catch (ErrorException & ex) {
+		cerr << "Error: " << ex.getMessage() << endl;
+		return 1;
+	}
+	return 0;
 }
@@ -0,0 +1,83 @@
+/*
+ * File: atom.cpp
+ * --------------
+ * This file implements the atom.h interface.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "atom.h"
+#include "memusage.h"
+
+#ifdef ATOM_TABLE_USE_MAP
+#include "../StanfordCPPLib/map.h"
+#else
+#include "symboltable.h"
+#endif
+using namespace std;
+
+/*
+ * Implementation notes: the atom table
+ * ------------------------------------
+ * Names are mapped to atoms by a SymbolTable, or by a StanfordCPPLib
+ * Map when ATOM_TABLE_USE_MAP is defined, and atoms are mapped back to
+ * names by a vector.  Both live in function-level statics so that they
+ * are constructed on first use.  Atoms are never freed, so each new
+ * name is charged to MEM_VARIABLES once.
+ */
+
+#ifdef ATOM_TABLE_USE_MAP
+typedef Map<string,int> AtomIndex;
+
+static bool lookupIndex(AtomIndex & index, string_view name, Atom & atom) {
+   string key(name);
+   if (!index.containsKey(key)) return false;
+   atom = index.get(key);
+   return true;
+}
+#else
+typedef SymbolTable AtomIndex;
+
+static bool lookupIndex(AtomIndex & index, string_view name, Atom & atom) {
+   const int *vp = index.lookup(name);
+   if (vp == NULL) return false;
+   atom = *vp;
+   return true;
+}
+#endif
+
+static AtomIndex & atomIndex() {
+   static AtomIndex index;
+   return index;
+}
+
+static vector<string> & atomNames() {
+   static vector<string> names;
+   return names;
+}
+
+Atom internAtom(string_view name) {
+   Atom atom;
+   if (lookupIndex(atomIndex(), name, atom)) return atom;
+   chargeMemory(MEM_VARIABLES, sizeof(string) + name.length());
+   vector<string> & names = atomNames();
+   atom = Atom(names.size());
+   names.push_back(string(name));
+   atomIndex().put(names.back(), atom);
+   return atom;
+}
+
+Atom findAtom(string_view name) {
+   Atom atom;
+   if (lookupIndex(atomIndex(), name, atom)) return atom;
+   return NO_ATOM;
+}
+
+const string & getAtomName(Atom atom) {
+   return atomNames()[atom];
+}
+
+int getAtomCount() {
+   return int(atomNames().size());
+}
@@ -0,0 +1,83 @@
+/*
+ * File: atom.h
+ * ------------
+ * This interface exports the atom table, which assigns each distinct
+ * identifier a small integer called an atom.  The parser interns every
+ * variable name it reads, expressions and statements store the atom,
+ * and EvalState uses the atom to index its variables, so comparing two
+ * names is comparing two ints and each name is stored once.
+ */
+
+#ifndef _atom_h
+#define _atom_h
+
+#include <string>
+#include <string_view>
+
+/*
+ * Type: Atom
+ * ----------
+ * An interned identifier.  Atoms are numbered consecutively from 0 in
+ * the order their names are first interned, and remain valid for the
+ * life of the interpreter.
+ */
+
+typedef int Atom;
+
+/*
+ * Constant: NO_ATOM
+ * -----------------
+ * The value findAtom returns for a name that has never been interned.
+ */
+
+const Atom NO_ATOM = -1;
+
+/*
+ * Build option: ATOM_TABLE_USE_MAP
+ * --------------------------------
+ * The atom table finds the atom for a name in a SymbolTable, an
+ * open-addressing hash table.  Defining ATOM_TABLE_USE_MAP when
+ * compiling the interpreter switches that lookup to the StanfordCPPLib
+ * Map, for comparison; symbolbench.cpp times the two.
+ */
+
+/*
+ * Function: internAtom
+ * Usage: Atom atom = internAtom(name);
+ * ------------------------------------
+ * Returns the atom for name, creating a new one if name has not been
+ * seen before.
+ */
+
+Atom internAtom(std::string_view name);
+
+/*
+ * Function: findAtom
+ * Usage: Atom atom = findAtom(name);
+ * ----------------------------------
+ * Returns the atom for name, or NO_ATOM if name has never been interned.
+ * Unlike internAtom, this function never adds to the table.
+ */
+
+Atom findAtom(std::string_view name);
+
+/*
+ * Function: getAtomName
+ * Usage: string name = getAtomName(atom);
+ * ---------------------------------------
+ * Returns the name that atom was interned from.
+ */
+
+const std::string & getAtomName(Atom atom);
+
+/*
+ * Function: getAtomCount
+ * Usage: int n = getAtomCount();
+ * ------------------------------
+ * Returns the number of atoms interned so far, which is one more than
+ * the largest atom.
+ */
+
+int getAtomCount();
+
+#endif
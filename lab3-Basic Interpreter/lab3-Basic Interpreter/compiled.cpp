@@ -0,0 +1,522 @@
+/*
+ * File: compiled.cpp
+ * ------------------
+ * This file implements the compiled.h interface.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "compiled.h"
+#include "exp.h"
+#include "readfile.h"
+#include "statement.h"
+
+#include "../StanfordCPPLib/error.h"
+#include "../StanfordCPPLib/strlib.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/*
+ * Implementation notes: image layout
+ * ----------------------------------
+ * An image is a flat sequence of native-endian 32-bit integers, bytes
+ * and length-prefixed strings, so it contains no pointers and can be
+ * read from any address.  The layout is:
+ *
+ *    "BBC\0" version payloadHash(8 bytes)
+ *    sourceFile sourceHash(8 bytes) lineCount
+ *    lineCount times:  lineNumber source statement
+ *
+ * The payload hash is FNV-1a over every byte that follows it.  The
+ * source file name is empty when the image is not tied to a file.
+ *
+ * A statement is its StatementType as a byte followed by its fields,
+ * and an expression is its ExpressionType as a byte followed by either
+ * a constant, a name, or an operator and two subexpressions.
+ */
+
+static const char COMPILED_MAGIC[4] = { 'B', 'B', 'C', '\0' };
+
+static void writeInt(string & out, int value) {
+   out.append((const char *) &value, sizeof value);
+}
+
+static void writeString(string & out, const string & str) {
+   writeInt(out, int(str.length()));
+   out.append(str);
+}
+
+static void writeExp(string & out, Expression *exp) {
+   ExpressionType type = exp->getType();
+   out += char(type);
+   switch (type) {
+    case CONSTANT:
+      writeInt(out, ((ConstantExp *) exp)->getValue());
+      break;
+    case IDENTIFIER:
+      writeString(out, ((IdentifierExp *) exp)->getName());
+      break;
+    case COMPOUND:
+      writeString(out, ((CompoundExp *) exp)->getOp());
+      writeExp(out, ((CompoundExp *) exp)->getLHS());
+      writeExp(out, ((CompoundExp *) exp)->getRHS());
+      break;
+   }
+}
+
+static void writeStatement(string & out, Statement *stmt) {
+   StatementType type = stmt->getType();
+   out += char(type);
+   switch (type) {
+    case LET:
+      writeString(out, ((LETState *) stmt)->getVar());
+      writeExp(out, ((LETState *) stmt)->getExp());
+      break;
+    case PRINT:
+      writeExp(out, ((PRINTState *) stmt)->getExp());
+      break;
+    case INPUT:
+      writeString(out, ((INPUTState *) stmt)->getVar());
+      break;
+    case GOTO:
+      writeInt(out, ((GOTOState *) stmt)->getLineNumber());
+      break;
+    case IFTHEN:
+      writeExp(out, ((IFTHENState *) stmt)->getLHS());
+      out += ((IFTHENState *) stmt)->getCmp();
+      writeExp(out, ((IFTHENState *) stmt)->getRHS());
+      writeInt(out, ((IFTHENState *) stmt)->getLineNumber());
+      break;
+    default:
+      break;
+   }
+}
+
+/*
+ * Implementation notes: ImageReader
+ * ---------------------------------
+ * The reader walks a cursor over the loaded image and checks every read
+ * against the end of the buffer, so a truncated or damaged file produces
+ * an error rather than reading past the end.  As in the parser, decoded
+ * subtrees are held in unique_ptrs until the node that owns them has
+ * been constructed, since that allocation can itself run out of memory.
+ */
+
+struct ImageReader {
+   const char *cp;
+   const char *end;
+
+   void need(size_t n) {
+      if (size_t(end - cp) < n) error("LOAD COMPILED: image is truncated");
+   }
+
+   char readByte() {
+      need(1);
+      return *cp++;
+   }
+
+   int readInt() {
+      int value;
+      need(sizeof value);
+      memcpy(&value, cp, sizeof value);
+      cp += sizeof value;
+      return value;
+   }
+
+   string readString() {
+      int length = readInt();
+      if (length < 0) error("LOAD COMPILED: image is corrupt");
+      need(length);
+      string str(cp, length);
+      cp += length;
+      return str;
+   }
+};
+
+static Expression *readExp(ImageReader & reader) {
+   switch (reader.readByte()) {
+    case CONSTANT:
+      return new ConstantExp(reader.readInt());
+    case IDENTIFIER:
+      return new IdentifierExp(reader.readString());
+    case COMPOUND: {
+      string op = reader.readString();
+      unique_ptr<Expression> lhs(readExp(reader));
+      unique_ptr<Expression> rhs(readExp(reader));
+      Expression *exp = new CompoundExp(op, lhs.get(), rhs.get());
+      lhs.release();
+      rhs.release();
+      return exp;
+    }
+   }
+   error("LOAD COMPILED: image is corrupt");
+   return NULL;
+}
+
+static Statement *readStatement(ImageReader & reader) {
+   switch (reader.readByte()) {
+    case REM:
+      return new REMSTATE();
+    case LET: {
+      string var = reader.readString();
+      unique_ptr<Expression> exp(readExp(reader));
+      Statement *stmt = new LETState(var, exp.get());
+      exp.release();
+      return stmt;
+    }
+    case PRINT: {
+      unique_ptr<Expression> exp(readExp(reader));
+      Statement *stmt = new PRINTState(exp.get());
+      exp.release();
+      return stmt;
+    }
+    case INPUT:
+      return new INPUTState(reader.readString());
+    case END:
+      return new ENDState();
+    case GOTO:
+      return new GOTOState(reader.readInt());
+    case IFTHEN: {
+      unique_ptr<Expression> lhs(readExp(reader));
+      char cmp = reader.readByte();
+      unique_ptr<Expression> rhs(readExp(reader));
+      int lineNumber = reader.readInt();
+      Statement *stmt = new IFTHENState(lhs.get(), cmp, rhs.get(),
+                                        lineNumber);
+      lhs.release();
+      rhs.release();
+      return stmt;
+    }
+   }
+   error("LOAD COMPILED: image is corrupt");
+   return NULL;
+}
+
+/*
+ * Implementation notes: hashProgramSource
+ * ---------------------------------------
+ * Each source line is hashed followed by a newline so that moving text
+ * from the end of one line to the start of the next changes the hash.
+ */
+
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+static unsigned long long hashBytes(unsigned long long h, const char *cp,
+                                    size_t length) {
+   for (size_t i = 0; i < length; i++) {
+      h ^= (unsigned char) cp[i];
+      h *= FNV_PRIME;
+   }
+   return h;
+}
+
+static unsigned long long hashText(unsigned long long h, const string & str) {
+   h = hashBytes(h, str.data(), str.length());
+   h ^= '\n';
+   h *= FNV_PRIME;
+   return h;
+}
+
+unsigned long long hashFileContents(const string & text) {
+   return hashBytes(FNV_OFFSET, text.data(), text.length());
+}
+
+unsigned long long hashProgramSource(Program & program) {
+   unsigned long long h = FNV_OFFSET;
+   for (int line = program.getFirstLineNumber(); line != -1;
+        line = program.getNextLineNumber(line)) {
+      h = hashText(h, program.getSourceLine(line));
+   }
+   return h;
+}
+
+/*
+ * Implementation notes: saveCompiledProgram, cacheCompiledProgram
+ * ---------------------------------------------------------------
+ * The whole image is assembled in memory by buildImage, its payload
+ * hash is filled in last, and it is written with one call.  The
+ * program's origin is only recorded if the program text still hashes
+ * to the value it had when the source file was loaded, since otherwise
+ * the image would claim to match a file it no longer matches.
+ *
+ * A cache image is written to a temporary file that is then renamed
+ * over the old image.  Another invocation that has the old image mapped
+ * keeps reading the old file, and one that opens the cache never sees a
+ * partly written image.  The temporary name includes the process ID on
+ * POSIX systems so that two invocations caching the same source at once
+ * do not write to the same file.
+ */
+
+static string buildImage(Program & program) {
+   string image(COMPILED_MAGIC, sizeof COMPILED_MAGIC);
+   writeInt(image, COMPILED_VERSION);
+   size_t hashOffset = image.length();
+   unsigned long long payloadHash = 0;
+   image.append((const char *) &payloadHash, sizeof payloadHash);
+   string sourceFile = program.getOriginFile();
+   unsigned long long sourceHash = program.getOriginFileHash();
+   if (sourceFile != ""
+       && hashProgramSource(program) != program.getOriginTextHash()) {
+      sourceFile = "";
+      sourceHash = 0;
+   }
+   writeString(image, sourceFile);
+   image.append((const char *) &sourceHash, sizeof sourceHash);
+   int count = 0;
+   for (int line = program.getFirstLineNumber(); line != -1;
+        line = program.getNextLineNumber(line)) {
+      count++;
+   }
+   writeInt(image, count);
+   for (int line = program.getFirstLineNumber(); line != -1;
+        line = program.getNextLineNumber(line)) {
+      writeInt(image, line);
+      writeString(image, program.getSourceLine(line));
+      writeStatement(image, program.getParsedStatement(line));
+   }
+   size_t payload = hashOffset + sizeof payloadHash;
+   payloadHash = hashBytes(FNV_OFFSET, image.data() + payload,
+                           image.length() - payload);
+   memcpy(&image[hashOffset], &payloadHash, sizeof payloadHash);
+   return image;
+}
+
+static bool writeImage(const string & image, const string & filename) {
+   ofstream out(filename.c_str(), ios::binary | ios::trunc);
+   out.write(image.data(), image.length());
+   out.close();
+   return !out.fail();
+}
+
+void saveCompiledProgram(Program & program, const string & filename) {
+   if (!writeImage(buildImage(program), filename)) {
+      error("SAVE COMPILED: can't write " + filename);
+   }
+}
+
+string getCacheFileName(const string & filename) {
+   return filename + ".bbc";
+}
+
+void cacheCompiledProgram(Program & program) {
+   string filename = program.getOriginFile();
+   if (filename == "") return;
+   string cacheFile = getCacheFileName(filename);
+   string tempFile = cacheFile + ".tmp";
+#ifndef _WIN32
+   tempFile += integerToString(getpid());
+#endif
+   if (!writeImage(buildImage(program), tempFile)) {
+      remove(tempFile.c_str());
+      return;
+   }
+#ifdef _WIN32
+   remove(cacheFile.c_str());
+#endif
+   if (rename(tempFile.c_str(), cacheFile.c_str()) != 0) {
+      remove(tempFile.c_str());
+   }
+}
+
+/*
+ * Implementation notes: ImageFile
+ * -------------------------------
+ * On POSIX systems an image that is a regular file is mapped privately
+ * and read-only and decoded where it lies, as Lexicon::readNativeFile
+ * does with native lexicons, so loading copies nothing but the source
+ * text of each line.  The file is checked with stat before it is
+ * opened, since opening a FIFO only to close it again would throw away
+ * what its writer sends.  A file that cannot be mapped, such as a pipe
+ * or an empty file, and every file on other systems is read into a
+ * string by readWholeFile.
+ */
+
+class ImageFile {
+public:
+   ImageFile();
+   ~ImageFile();
+   bool open(const string & filename);
+   const char *begin() const;
+   const char *end() const;
+
+private:
+   const char *base;
+   size_t length;
+   bool mapped;
+   string buffer;
+
+   ImageFile(const ImageFile &);
+   ImageFile & operator=(const ImageFile &);
+};
+
+ImageFile::ImageFile() {
+   base = NULL;
+   length = 0;
+   mapped = false;
+}
+
+ImageFile::~ImageFile() {
+#ifndef _WIN32
+   if (mapped) munmap((void *) base, length);
+#endif
+}
+
+bool ImageFile::open(const string & filename) {
+#ifndef _WIN32
+   struct stat sb;
+   if (stat(filename.c_str(), &sb) == 0 && S_ISREG(sb.st_mode)) {
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+         void *addr = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (addr != MAP_FAILED) {
+            close(fd);
+            base = (const char *) addr;
+            length = sb.st_size;
+            mapped = true;
+            return true;
+         }
+      }
+      close(fd);
+   }
+#endif
+   ifstream infile(filename.c_str(), ios::binary);
+   if (infile.fail() || !readWholeFile(infile, buffer)) return false;
+   base = buffer.data();
+   length = buffer.length();
+   return true;
+}
+
+const char *ImageFile::begin() const {
+   return base;
+}
+
+const char *ImageFile::end() const {
+   return base + length;
+}
+
+/*
+ * Implementation notes: loadCompiledProgram, loadCachedProgram
+ * ------------------------------------------------------------
+ * readImageHeader checks the image's magic number, version and payload
+ * hash before anything is decoded and reads the source file it records.
+ * readImageLines then decodes every line into a temporary table, whose
+ * entries own their statements, and adds the lines to a separate
+ * program that takes each statement only once its line exists.  The new
+ * program is swapped in at the end, so an error at any point, including
+ * running out of memory, leaves the current program intact and frees
+ * whatever had been built.
+ *
+ * LOAD COMPILED rejects an image whose recorded source file can still
+ * be read but no longer hashes to the recorded value.  A cache image is
+ * used only if it records exactly the file being loaded and the hash
+ * the caller computed from that file's contents; any other image, and
+ * any error while decoding it, makes loadCachedProgram return false so
+ * that the caller parses the source instead.
+ */
+
+struct CompiledLine {
+   int lineNumber;
+   string source;
+   unique_ptr<Statement> stmt;
+};
+
+static unsigned long long readHash(ImageReader & reader) {
+   unsigned long long hash;
+   reader.need(sizeof hash);
+   memcpy(&hash, reader.cp, sizeof hash);
+   reader.cp += sizeof hash;
+   return hash;
+}
+
+static void readImageHeader(ImageReader & reader, const string & filename,
+                            string & sourceFile,
+                            unsigned long long & sourceHash) {
+   reader.need(sizeof COMPILED_MAGIC);
+   if (memcmp(reader.cp, COMPILED_MAGIC, sizeof COMPILED_MAGIC) != 0) {
+      error("LOAD COMPILED: " + filename + " is not a compiled program");
+   }
+   reader.cp += sizeof COMPILED_MAGIC;
+   if (reader.readInt() != COMPILED_VERSION) {
+      error("LOAD COMPILED: " + filename + " has the wrong version");
+   }
+   unsigned long long payloadHash = readHash(reader);
+   if (hashBytes(FNV_OFFSET, reader.cp, reader.end - reader.cp)
+       != payloadHash) {
+      error("LOAD COMPILED: " + filename + " is damaged");
+   }
+   sourceFile = reader.readString();
+   sourceHash = readHash(reader);
+}
+
+static void readImageLines(ImageReader & reader, Program & loaded) {
+   int count = reader.readInt();
+   vector<CompiledLine> lines;
+   for (int i = 0; i < count; i++) {
+      CompiledLine entry;
+      entry.lineNumber = reader.readInt();
+      entry.source = reader.readString();
+      entry.stmt.reset(readStatement(reader));
+      lines.push_back(std::move(entry));
+   }
+   for (size_t i = 0; i < lines.size(); i++) {
+      loaded.addSourceLine(lines[i].lineNumber, lines[i].source);
+      loaded.setParsedStatement(lines[i].lineNumber, lines[i].stmt.get());
+      lines[i].stmt.release();
+   }
+}
+
+void loadCompiledProgram(Program & program, const string & filename) {
+   ImageFile file;
+   if (!file.open(filename)) error("LOAD COMPILED: can't open " + filename);
+   ImageReader reader = { file.begin(), file.end() };
+   string sourceFile;
+   unsigned long long sourceHash;
+   readImageHeader(reader, filename, sourceFile, sourceHash);
+   if (sourceFile != "") {
+      ifstream source(sourceFile.c_str(), ios::binary);
+      string text;
+      if (!source.fail() && readWholeFile(source, text)
+          && hashFileContents(text) != sourceHash) {
+         error("LOAD COMPILED: " + filename + " is out of date with "
+               + sourceFile);
+      }
+   }
+   Program loaded;
+   readImageLines(reader, loaded);
+   if (sourceFile != "") {
+      loaded.setOrigin(sourceFile, sourceHash, hashProgramSource(loaded));
+   }
+   program.swap(loaded);
+}
+
+bool loadCachedProgram(Program & program, const string & filename,
+                       unsigned long long fileHash) {
+   string cacheFile = getCacheFileName(filename);
+   ImageFile file;
+   if (!file.open(cacheFile)) return false;
+   try {
+      ImageReader reader = { file.begin(), file.end() };
+      string sourceFile;
+      unsigned long long sourceHash;
+      readImageHeader(reader, cacheFile, sourceFile, sourceHash);
+      if (sourceFile != filename || sourceHash != fileHash) return false;
+      Program loaded;
+      readImageLines(reader, loaded);
+      loaded.setOrigin(filename, fileHash, hashProgramSource(loaded));
+      program.swap(loaded);
+   } catch (ErrorException &) {
+      return false;
+   }
+   return true;
+}
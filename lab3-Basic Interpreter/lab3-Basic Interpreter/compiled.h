@@ -0,0 +1,116 @@
+/*
+ * File: compiled.h
+ * ----------------
+ * This interface exports functions that save a parsed BASIC program
+ * to a binary image and load it back without running the scanner or
+ * the parser.  An image file conventionally has the extension .bbc.
+ * LOAD also keeps an image of each source file it reads next to that
+ * file and uses it in place of the source while the source is unchanged.
+ */
+
+#ifndef _compiled_h
+#define _compiled_h
+
+#include <string>
+#include "program.h"
+
+/*
+ * Constant: COMPILED_VERSION
+ * --------------------------
+ * The format version written into every image.  Images written with a
+ * different version are rejected by loadCompiledProgram.
+ */
+
+const int COMPILED_VERSION = 2;
+
+/*
+ * Function: saveCompiledProgram
+ * Usage: saveCompiledProgram(program, filename);
+ * ----------------------------------------------
+ * Writes the program to the named file as a binary image.  The image
+ * holds the line table, the source text of every line (so that LIST
+ * still works after loading), and the parsed statements encoded as
+ * position-independent records, all covered by a hash that detects
+ * damage to the image.  If the program was loaded from a source file
+ * and has not been changed since, the image also records the name of
+ * that file and a hash of its contents.  If the file cannot be written,
+ * this function calls error.
+ */
+
+void saveCompiledProgram(Program & program, const std::string & filename);
+
+/*
+ * Function: loadCompiledProgram
+ * Usage: loadCompiledProgram(program, filename);
+ * ----------------------------------------------
+ * Replaces the contents of program with the image stored in the named
+ * file.  On POSIX systems the file is mapped into memory rather than
+ * read.  The statements are rebuilt directly from their records, so no
+ * source line is scanned or parsed.  If the image records a source file
+ * that can still be read, the file is hashed again and an image whose
+ * source has changed since it was saved is rejected as out of date.  If
+ * the file is missing, is not an image of the current version, is
+ * truncated or damaged, or is out of date, this function calls error
+ * and leaves program unchanged.
+ */
+
+void loadCompiledProgram(Program & program, const std::string & filename);
+
+/*
+ * Function: getCacheFileName
+ * Usage: string cacheFile = getCacheFileName(filename);
+ * -----------------------------------------------------
+ * Returns the name of the cache image kept for the named source file,
+ * which is the source file name followed by .bbc.
+ */
+
+std::string getCacheFileName(const std::string & filename);
+
+/*
+ * Function: cacheCompiledProgram
+ * Usage: cacheCompiledProgram(program);
+ * -------------------------------------
+ * Writes the program to the cache image of the source file it was
+ * loaded from.  The image replaces any earlier one in a single step, so
+ * that another invocation never reads a partly written image.  If the
+ * program has no source file, or the image cannot be written, the
+ * program simply goes uncached and no error is reported.
+ */
+
+void cacheCompiledProgram(Program & program);
+
+/*
+ * Function: loadCachedProgram
+ * Usage: if (loadCachedProgram(program, filename, fileHash)) ...
+ * ---------------------------------------------------------------
+ * Replaces the contents of program with the cache image of the named
+ * source file and returns true, provided the image records that file
+ * and fileHash, the hash of its current contents.  If there is no such
+ * image, or it is out of date or cannot be loaded for any reason, this
+ * function returns false and leaves program unchanged.
+ */
+
+bool loadCachedProgram(Program & program, const std::string & filename,
+                       unsigned long long fileHash);
+
+/*
+ * Function: hashProgramSource
+ * Usage: unsigned long long hash = hashProgramSource(program);
+ * ------------------------------------------------------------
+ * Returns a 64-bit FNV-1a hash of the program's source lines in line
+ * order.  Two programs with the same text have the same hash.
+ */
+
+unsigned long long hashProgramSource(Program & program);
+
+/*
+ * Function: hashFileContents
+ * Usage: unsigned long long hash = hashFileContents(text);
+ * --------------------------------------------------------
+ * Returns a 64-bit FNV-1a hash of the bytes of text, which loaders use
+ * to recognize the contents of a source file.
+ */
+
+unsigned long long hashFileContents(const std::string & text);
+
+#endif
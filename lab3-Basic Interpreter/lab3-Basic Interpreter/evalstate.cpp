@@ -6,40 +6,161 @@
  * methods are simple enough that they need no individual documentation.
  */
 
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include "evalstate.h"
+#include "memusage.h"
 
-#include "../StanfordCPPLib/map.h"
+#include "../StanfordCPPLib/error.h"
 using namespace std;
 
 /* Implementation of the EvalState class */
 
 EvalState::EvalState() {
-   /* Empty */
+   pages = make_shared<PageTable>();
+   pendingJump = -1;
+   inputFeed = NULL;
+   trace = NULL;
 }
 
 EvalState::~EvalState() {
    /* Empty */
 }
 
-void EvalState::setValue(string var, int value) {
-   symbolTable.put(var, value);
+/*
+ * Implementation notes: variable storage
+ * --------------------------------------
+ * Atom n lives in slot n % PAGE_SIZE of page n / PAGE_SIZE.  Reads go
+ * straight to the page.  The string_view methods translate the name
+ * first; lookups use findAtom so that asking about an unknown name does
+ * not add it to the atom table.
+ */
+
+void EvalState::setValue(string_view var, int value) {
+   setValue(internAtom(var), value);
+}
+
+void EvalState::setValue(Atom var, int value) {
+   VariablePage & page = writablePage(var);
+   page.values[var % PAGE_SIZE] = value;
+   page.defined |= 1ULL << (var % PAGE_SIZE);
+}
+
+int EvalState::getValue(string_view var) {
+   return getValue(findAtom(var));
+}
+
+int EvalState::getValue(Atom var) {
+   return isDefined(var) ? (*pages)[var / PAGE_SIZE]->values[var % PAGE_SIZE] : 0;
+}
+
+bool EvalState::isDefined(string_view var) {
+   return isDefined(findAtom(var));
+}
+
+bool EvalState::isDefined(Atom var) {
+   if (var < 0 || var / PAGE_SIZE >= int(pages->size())) return false;
+   VariablePage *page = (*pages)[var / PAGE_SIZE].get();
+   return page != NULL && (page->defined >> (var % PAGE_SIZE) & 1) != 0;
+}
+
+void EvalState::eraseValue(string_view var) {
+   eraseValue(findAtom(var));
+}
+
+void EvalState::eraseValue(Atom var) {
+   if (isDefined(var)) {
+      writablePage(var).defined &= ~(1ULL << (var % PAGE_SIZE));
+   }
+}
+
+void EvalState::clear() {
+   pages = make_shared<PageTable>();
+}
+
+/*
+ * Implementation notes: writablePage
+ * ----------------------------------
+ * Before a write, the page table and then the page holding var are
+ * copied if anything else (a copy of this EvalState or a snapshot)
+ * still refers to them.  Afterwards this EvalState is their only owner
+ * and can modify them in place.
+ */
+
+EvalState::VariablePage & EvalState::writablePage(Atom var) {
+   if (pages.use_count() > 1) {
+      pages = make_shared<PageTable>(*pages);
+   }
+   PageTable & table = *pages;
+   int index = var / PAGE_SIZE;
+   if (index >= int(table.size())) {
+      table.resize(index + 1);
+   }
+   if (!table[index]) {
+      table[index] = newPage(NULL);
+   } else if (table[index].use_count() > 1) {
+      table[index] = newPage(table[index].get());
+   }
+   return *table[index];
+}
+
+/*
+ * Implementation notes: newPage
+ * -----------------------------
+ * Returns a new page, zeroed or copied from src.  Pages are charged to
+ * MEM_VARIABLES when they are made and released by the deleter when the
+ * last EvalState or snapshot holding them lets go, so pages shared with
+ * snapshots are counted once.
+ */
+
+shared_ptr<EvalState::VariablePage> EvalState::newPage(const VariablePage *src) {
+   chargeMemory(MEM_VARIABLES, sizeof(VariablePage));
+   VariablePage *page = new VariablePage();
+   if (src != NULL) *page = *src;
+   return shared_ptr<VariablePage>(page, [](VariablePage *page) {
+      releaseMemory(MEM_VARIABLES, sizeof(VariablePage));
+      delete page;
+   });
+}
+
+void EvalState::saveSnapshot(const string & name) {
+   snapshots[name] = pages;
+}
+
+void EvalState::restoreSnapshot(const string & name) {
+   map<string, shared_ptr<PageTable> >::iterator it = snapshots.find(name);
+   if (it == snapshots.end()) error("no snapshot named " + name);
+   pages = it->second;
+}
+
+bool EvalState::hasSnapshot(const string & name) const {
+   return snapshots.find(name) != snapshots.end();
+}
+
+void EvalState::setJump(int lineNumber) {
+   pendingJump = lineNumber;
+}
+
+int EvalState::takeJump() {
+   int lineNumber = pendingJump;
+   pendingJump = -1;
+   return lineNumber;
+}
+
+void EvalState::setInputFeed(InputFeed *feed) {
+   inputFeed = feed;
+}
+
+InputFeed *EvalState::getInputFeed() {
+   return inputFeed;
 }
 
-int EvalState::getValue(string var) {
-   return symbolTable.get(var);
+void EvalState::setTrace(ExecutionTrace *trace) {
+   this->trace = trace;
 }
 
-bool EvalState::isDefined(string var) {
-   return symbolTable.containsKey(var);
-}
-
-void EvalState::eraseValue(std::string var)
-{
-	symbolTable.remove(var);
-}
-
-void EvalState::clear()
-{
-	symbolTable.clear();
+ExecutionTrace *EvalState::getTrace() {
+   return trace;
 }
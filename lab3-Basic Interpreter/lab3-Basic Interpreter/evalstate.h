@@ -9,8 +9,14 @@
 #ifndef _evalstate_h
 #define _evalstate_h
 
+#include <map>
+#include <memory>
 #include <string>
-#include "../StanfordCPPLib/map.h"
+#include <string_view>
+#include <vector>
+#include "atom.h"
+#include "inputfeed.h"
+#include "trace.h"
 
 /*
  * Class: EvalState
@@ -19,7 +25,13 @@
  * of the evaluator and contains information from the evaluation
  * environment that the evaluator may need to know.  In this
  * version, the only information maintained by the EvalState class
- * is a symbol table that maps variable names into their values.
+ * is a symbol table that maps variables into their values, along
+ * with any jump requested by the statement being executed.  Every
+ * variable method is available both for a name and for its atom.
+ *
+ * The variables are kept in copy-on-write pages, so copying an
+ * EvalState, or saving a named snapshot of it, takes constant time;
+ * pages are duplicated only when one of the copies next writes to them.
  * Several of the exercises, however, require you to include
  * additional information in the EvalState class.
  */
@@ -46,6 +58,18 @@ public:
 
    ~EvalState();
 
+/*
+ * Copying: EvalState(src), operator=
+ * Usage: EvalState copy = state;
+ * ------------------------------
+ * Copies the variables of src in constant time.  The copy shares
+ * storage with src until either of them assigns a variable.  Named
+ * snapshots are copied with the variables.
+ */
+
+   EvalState(const EvalState & src) = default;
+   EvalState & operator=(const EvalState & src) = default;
+
 /*
  * Method: setValue
  * Usage: state.setValue(var, value);
@@ -53,7 +77,8 @@ public:
  * Sets the value associated with the specified var.
  */
 
-   void setValue(std::string var, int value);
+   void setValue(std::string_view var, int value);
+   void setValue(Atom var, int value);
 
 /*
  * Method: getValue
@@ -62,7 +87,8 @@ public:
  * Returns the value associated with the specified variable.
  */
 
-   int getValue(std::string var);
+   int getValue(std::string_view var);
+   int getValue(Atom var);
 
 /*
  * Method: isDefined
@@ -71,7 +97,8 @@ public:
  * Returns true if the specified variable is defined.
  */
 
-   bool isDefined(std::string var);
+   bool isDefined(std::string_view var);
+   bool isDefined(Atom var);
 
 /*
  * Method: eraseValue
@@ -80,7 +107,8 @@ public:
  * Erase the key-value both according to the specified variable.
  */
 
-   void eraseValue(std::string var);
+   void eraseValue(std::string_view var);
+   void eraseValue(Atom var);
 
 /*
  * Method: clear
@@ -91,9 +119,110 @@ public:
 
    void clear();
 
+/*
+ * Method: setJump
+ * Usage: state.setJump(lineNumber);
+ * ---------------------------------
+ * Records that the statement being executed transfers control to the
+ * specified line.  GOTO and IF_THEN use this to signal a jump to RUN.
+ */
+
+   void setJump(int lineNumber);
+
+/*
+ * Method: takeJump
+ * Usage: int lineNumber = state.takeJump();
+ * -----------------------------------------
+ * Returns the line number passed to the last call to setJump and
+ * clears it, or returns -1 if no jump is pending.
+ */
+
+   int takeJump();
+
+/*
+ * Method: saveSnapshot
+ * Usage: state.saveSnapshot(name);
+ * --------------------------------
+ * Records the current variables under the specified name, replacing
+ * any earlier snapshot of that name.  This takes constant time.
+ */
+
+   void saveSnapshot(const std::string & name);
+
+/*
+ * Method: restoreSnapshot
+ * Usage: state.restoreSnapshot(name);
+ * -----------------------------------
+ * Replaces the current variables with those recorded by the snapshot
+ * of the specified name, which remains available for later restores.
+ * This takes constant time.  If there is no such snapshot, this method
+ * calls error.
+ */
+
+   void restoreSnapshot(const std::string & name);
+
+/*
+ * Method: hasSnapshot
+ * Usage: if (state.hasSnapshot(name)) ...
+ * ---------------------------------------
+ * Returns true if a snapshot with the specified name has been saved.
+ */
+
+   bool hasSnapshot(const std::string & name) const;
+
+/*
+ * Methods: setInputFeed, getInputFeed
+ * Usage: state.setInputFeed(&feed);
+ *        InputFeed *feed = state.getInputFeed();
+ * ----------------------------------------------
+ * Sets or returns the InputFeed that INPUT statements consult before
+ * prompting the user.  The feed is owned by the caller and may be NULL,
+ * which is the initial setting.
+ */
+
+   void setInputFeed(InputFeed *feed);
+   InputFeed *getInputFeed();
+
+/*
+ * Methods: setTrace, getTrace
+ * Usage: state.setTrace(&trace);
+ *        ExecutionTrace *trace = state.getTrace();
+ * ------------------------------------------------
+ * Sets or returns the ExecutionTrace to which INPUT and PRINT statements
+ * report their values.  The trace is owned by the caller and may be
+ * NULL, which is the initial setting and disables tracing.
+ */
+
+   void setTrace(ExecutionTrace *trace);
+   ExecutionTrace *getTrace();
+
 private:
 
-   Map<std::string,int> symbolTable;
+/*
+ * Type: VariablePage
+ * ------------------
+ * A page holds the values of PAGE_SIZE consecutive atoms along with a
+ * bit mask recording which of them are defined.  Pages are shared
+ * between copies of an EvalState until one of them writes.
+ */
+
+   static const int PAGE_SIZE = 64;
+
+   struct VariablePage {
+      int values[PAGE_SIZE];
+      unsigned long long defined;
+   };
+
+   typedef std::vector<std::shared_ptr<VariablePage> > PageTable;
+
+   std::shared_ptr<PageTable> pages;    /* The variables, by atom       */
+   std::map<std::string, std::shared_ptr<PageTable> > snapshots;
+   int pendingJump;                     /* Requested jump target, or -1 */
+   InputFeed *inputFeed;                /* Pre-supplied INPUT values    */
+   ExecutionTrace *trace;               /* Recorder of INPUT and PRINT  */
+
+   VariablePage & writablePage(Atom var);
+   static std::shared_ptr<VariablePage> newPage(const VariablePage *src);
 
 };
 
@@ -8,6 +8,7 @@
 #include "../StanfordCPPLib/error.h"
 #include "evalstate.h"
 #include "exp.h"
+#include "memusage.h"
 
 #include "../StanfordCPPLib/strlib.h"
 
@@ -27,6 +28,76 @@ Expression::~Expression() {
    /* Empty */
 }
 
+/*
+ * Implementation notes: the expression node pool
+ * ----------------------------------------------
+ * Node storage is carved out of large blocks and sorted into size
+ * classes that are multiples of POOL_GRANULE bytes.  A freed node goes
+ * onto the free list for its size class and is handed out again by the
+ * next allocation of the same class, so a program that is parsed,
+ * edited and reparsed reuses the same memory.  Blocks are never returned
+ * to the heap.  Requests larger than the biggest size class, which can
+ * only come from subclasses added later, fall through to ::operator new.
+ * Each node is charged to MEM_EXPRESSIONS at the size of its class when
+ * it is handed out and released when it is freed, so the category shows
+ * the nodes that are live rather than the blocks that have been carved.
+ */
+
+static const size_t POOL_GRANULE = 8;
+static const size_t POOL_CLASSES = 16;
+static const size_t POOL_BLOCK_SIZE = 16384;
+
+struct FreeNode {
+   FreeNode *link;
+};
+
+static FreeNode *freeLists[POOL_CLASSES];
+static char *blockNext = NULL;
+static char *blockEnd = NULL;
+
+void *Expression::operator new(size_t size) {
+   size_t sizeClass = (size + POOL_GRANULE - 1) / POOL_GRANULE;
+   if (sizeClass == 0) sizeClass = 1;
+   if (sizeClass >= POOL_CLASSES) {
+      chargeMemory(MEM_EXPRESSIONS, size);
+      return ::operator new(size);
+   }
+   size_t bytes = sizeClass * POOL_GRANULE;
+   chargeMemory(MEM_EXPRESSIONS, bytes);
+   FreeNode *node = freeLists[sizeClass];
+   if (node != NULL) {
+      freeLists[sizeClass] = node->link;
+      return node;
+   }
+   if (blockNext == NULL || size_t(blockEnd - blockNext) < bytes) {
+      try {
+         blockNext = (char *) ::operator new(POOL_BLOCK_SIZE);
+      } catch (...) {
+         releaseMemory(MEM_EXPRESSIONS, bytes);
+         throw;
+      }
+      blockEnd = blockNext + POOL_BLOCK_SIZE;
+   }
+   void *ptr = blockNext;
+   blockNext += bytes;
+   return ptr;
+}
+
+void Expression::operator delete(void *ptr, size_t size) {
+   if (ptr == NULL) return;
+   size_t sizeClass = (size + POOL_GRANULE - 1) / POOL_GRANULE;
+   if (sizeClass == 0) sizeClass = 1;
+   if (sizeClass >= POOL_CLASSES) {
+      releaseMemory(MEM_EXPRESSIONS, size);
+      ::operator delete(ptr);
+      return;
+   }
+   releaseMemory(MEM_EXPRESSIONS, sizeClass * POOL_GRANULE);
+   FreeNode *node = (FreeNode *) ptr;
+   node->link = freeLists[sizeClass];
+   freeLists[sizeClass] = node;
+}
+
 /*
  * Implementation notes: the ConstantExp subclass
  * ----------------------------------------------
@@ -59,8 +130,9 @@ int ConstantExp::getValue() {
  * Implementation notes: the IdentifierExp subclass
  * ------------------------------------------------
  * The IdentifierExp subclass declares a single instance variable that
- * stores the name of the variable.  The implementation of eval must
- * look this variable up in the evaluation state.
+ * stores the atom for the name of the variable.  The implementation of
+ * eval must look this variable up in the evaluation state, which it
+ * does by atom.
  */
 
 IdentifierExp::IdentifierExp(string name) {
@@ -69,19 +141,19 @@ IdentifierExp::IdentifierExp(string name) {
 		cout << "SYNTAX ERROR" << endl;
 		error("variable conflict to the reserved name");
 	}
-	this->name = name;
+	this->atom = internAtom(name);
 }
 
 int IdentifierExp::eval(EvalState & state) {
-	if (!state.isDefined(name)) {
+	if (!state.isDefined(atom)) {
 		cout << "VARIABLE NOT DEFINED" << endl;
 		error("VARIABLE NOT DEFINED");
 	}
-   return state.getValue(name);
+   return state.getValue(atom);
 }
 
 string IdentifierExp::toString() {
-   return name;
+   return getAtomName(atom);
 }
 
 ExpressionType IdentifierExp::getType() {
@@ -89,7 +161,11 @@ ExpressionType IdentifierExp::getType() {
 }
 
 string IdentifierExp::getName() {
-   return name;
+   return getAtomName(atom);
+}
+
+Atom IdentifierExp::getAtom() {
+   return atom;
 }
 
 /*
@@ -116,7 +192,10 @@ CompoundExp::~CompoundExp() {
  * --------------------------
  * The eval method for the compound expression case must check for the
  * assignment operator as a special case.  Unlike the arithmetic operators
- * the assignment operator does not evaluate its left operand.
+ * the assignment operator does not evaluate its left operand.  All of
+ * the operators are single characters, so eval dispatches on op[0]
+ * rather than comparing strings.  The comparison operators < and >
+ * yield 1 for true and 0 for false.
  */
 
 int CompoundExp::eval(EvalState & state) {
@@ -125,20 +204,25 @@ int CompoundExp::eval(EvalState & state) {
          error("Illegal variable in assignment");
       }
       int val = rhs->eval(state);
-      state.setValue(((IdentifierExp *) lhs)->getName(), val);
+      state.setValue(((IdentifierExp *) lhs)->getAtom(), val);
       return val;
    }
    int left = lhs->eval(state);
    int right = rhs->eval(state);
-   if (op == "+") return left + right;
-   if (op == "-") return left - right;
-   if (op == "*") return left * right;
-   if (op == "/") {
-	   if (right == 0) {
-		   cout << "DIVIDE BY ZERO" << endl;
-		   error("DIVIDE BY ZERO");
-	   }
-	   return left / right;
+   if (op.length() == 1) {
+      switch (op[0]) {
+       case '+': return left + right;
+       case '-': return left - right;
+       case '*': return left * right;
+       case '<': return left < right;
+       case '>': return left > right;
+       case '/':
+         if (right == 0) {
+            cout << "DIVIDE BY ZERO" << endl;
+            error("DIVIDE BY ZERO");
+         }
+         return left / right;
+      }
    }
    error("Illegal operator in expression");
    return 0;
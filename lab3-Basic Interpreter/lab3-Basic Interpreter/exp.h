@@ -9,6 +9,7 @@
 #ifndef _exp_h
 #define _exp_h
 
+#include <cstddef>
 #include "evalstate.h"
 
 /*
@@ -96,6 +97,20 @@ public:
 
    virtual ExpressionType getType() = 0;
 
+/*
+ * Operators: new, delete
+ * Usage: Expression *exp = new ConstantExp(value);
+ *        delete exp;
+ * ------------------------------------------------
+ * Expression nodes are small and are created and destroyed in large
+ * numbers by the parser, so all of the subclasses draw their storage
+ * from a node pool rather than from the general-purpose heap.  Clients
+ * continue to use new and delete exactly as before.
+ */
+
+   static void *operator new(std::size_t size);
+   static void operator delete(void *ptr, std::size_t size);
+
 };
 
 /*
@@ -160,7 +175,7 @@ public:
  * Usage: Expression *exp = new IdentifierExp(name);
  * -------------------------------------------------
  * The constructor initializes a new identifier expression
- * for the variable named by name.
+ * for the variable named by name, interning the name as an atom.
  */
 
    IdentifierExp(std::string name);
@@ -186,9 +201,19 @@ public:
 
    std::string getName();
 
+/*
+ * Method: getAtom
+ * Usage: Atom atom = ((IdentifierExp *) exp)->getAtom();
+ * ------------------------------------------------------
+ * Returns the interned atom for the identifier's name and can be
+ * applied only to an object known to be an IdentifierExp.
+ */
+
+   Atom getAtom();
+
 private:
 
-   std::string name;
+   Atom atom;
 
 };
 
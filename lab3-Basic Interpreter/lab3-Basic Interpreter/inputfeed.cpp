@@ -0,0 +1,90 @@
+/*
+ * File: inputfeed.cpp
+ * -------------------
+ * This file implements the InputFeed class.
+ */
+
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "inputfeed.h"
+#include "readfile.h"
+
+#include "../StanfordCPPLib/error.h"
+#include "../StanfordCPPLib/strlib.h"
+using namespace std;
+
+InputFeed::InputFeed() {
+   position = 0;
+   active = false;
+}
+
+/*
+ * Implementation notes: loadFile
+ * ------------------------------
+ * The whole file is read into memory by readWholeFile, which also
+ * accepts a pipe, and handed to loadText.
+ */
+
+void InputFeed::loadFile(const string & filename) {
+   ifstream infile(filename.c_str(), ios::binary);
+   if (infile.fail()) error("INPUTS: can't open " + filename);
+   string text;
+   if (!readWholeFile(infile, text)) error("INPUTS: can't read " + filename);
+   loadText(text);
+}
+
+/*
+ * Implementation notes: loadText
+ * ------------------------------
+ * The text is split in place and each field is converted directly from
+ * the buffer by tryStringToInteger, so no per-value strings are built.
+ * The new values are collected separately and swapped in only once the
+ * whole text has been converted.
+ */
+
+void InputFeed::loadText(const string & text) {
+   vector<int> parsed;
+   const char *cp = text.data();
+   const char *end = cp + text.length();
+   while (true) {
+      while (cp < end && (isspace((unsigned char) *cp) || *cp == ',')) cp++;
+      if (cp == end) break;
+      const char *start = cp;
+      while (cp < end && !isspace((unsigned char) *cp) && *cp != ',') cp++;
+      int value;
+      if (!tryStringToInteger(start, cp, value)) {
+         error("INPUTS: invalid number " + string(start, cp));
+      }
+      parsed.push_back(value);
+   }
+   values.swap(parsed);
+   position = 0;
+   active = true;
+}
+
+void InputFeed::loadValues(const vector<int> & values) {
+   this->values = values;
+   position = 0;
+   active = true;
+}
+
+void InputFeed::clear() {
+   values.clear();
+   position = 0;
+   active = false;
+}
+
+bool InputFeed::isActive() const {
+   return active;
+}
+
+int InputFeed::nextValue() {
+   if (position >= values.size()) error("INPUT: no more input values");
+   return values[position++];
+}
+
+int InputFeed::remaining() const {
+   return int(values.size() - position);
+}
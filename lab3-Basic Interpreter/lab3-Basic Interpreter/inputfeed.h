@@ -0,0 +1,113 @@
+/*
+ * File: inputfeed.h
+ * -----------------
+ * This interface exports the InputFeed class, which supplies the values
+ * for INPUT statements from a file instead of from the user.
+ */
+
+#ifndef _inputfeed_h
+#define _inputfeed_h
+
+#include <string>
+#include <vector>
+
+/*
+ * Class: InputFeed
+ * ----------------
+ * An InputFeed holds a queue of integers read in advance.  While a feed
+ * is active, INPUT takes its value from the front of the queue without
+ * printing a prompt or reading from the console.  A feed becomes active
+ * when values are loaded into it and inactive again when it is cleared.
+ */
+
+class InputFeed {
+
+public:
+
+/*
+ * Constructor: InputFeed
+ * Usage: InputFeed feed;
+ * ----------------------
+ * Creates an inactive feed.
+ */
+
+   InputFeed();
+
+/*
+ * Method: loadFile
+ * Usage: feed.loadFile(filename);
+ * -------------------------------
+ * Replaces the queue with the integers in the named file and activates
+ * the feed.  The values may be separated by any mix of whitespace and
+ * commas.  If the file cannot be read or contains something other than
+ * an integer, this method calls error and leaves the feed unchanged.
+ */
+
+   void loadFile(const std::string & filename);
+
+/*
+ * Method: loadText
+ * Usage: feed.loadText(text);
+ * ---------------------------
+ * Replaces the queue with the integers in text, in the same format as
+ * loadFile, and activates the feed.
+ */
+
+   void loadText(const std::string & text);
+
+/*
+ * Method: loadValues
+ * Usage: feed.loadValues(values);
+ * -------------------------------
+ * Replaces the queue with a copy of values and activates the feed.
+ */
+
+   void loadValues(const std::vector<int> & values);
+
+/*
+ * Method: clear
+ * Usage: feed.clear();
+ * --------------------
+ * Empties the queue and deactivates the feed.
+ */
+
+   void clear();
+
+/*
+ * Method: isActive
+ * Usage: if (feed.isActive()) ...
+ * -------------------------------
+ * Returns true if INPUT should read from this feed.  A feed remains
+ * active after its last value has been taken.
+ */
+
+   bool isActive() const;
+
+/*
+ * Method: nextValue
+ * Usage: int value = feed.nextValue();
+ * ------------------------------------
+ * Removes and returns the value at the front of the queue.  If the
+ * queue is empty, this method calls error.
+ */
+
+   int nextValue();
+
+/*
+ * Method: remaining
+ * Usage: int n = feed.remaining();
+ * --------------------------------
+ * Returns the number of values not yet taken.
+ */
+
+   int remaining() const;
+
+private:
+
+   std::vector<int> values;      /* The values, in order               */
+   size_t position;              /* The index of the next value        */
+   bool active;                  /* True once values have been loaded  */
+
+};
+
+#endif
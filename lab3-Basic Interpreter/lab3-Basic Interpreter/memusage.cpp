@@ -0,0 +1,58 @@
+/*
+ * File: memusage.cpp
+ * ------------------
+ * This file implements the memusage.h interface.
+ */
+
+#include <cstddef>
+#include "memusage.h"
+
+#include "../StanfordCPPLib/error.h"
+using namespace std;
+
+/*
+ * Implementation notes: memory accounting
+ * ---------------------------------------
+ * The counters are file statics.  An interpreter process runs a single
+ * session, so they are that session's figures.  They count the storage
+ * the interpreter asks for, without the heap's own overhead.
+ */
+
+static size_t memoryUsed[MEM_CATEGORIES];
+static size_t memoryTotal = 0;
+static size_t memoryLimit = 0;
+
+static const char *CATEGORY_NAMES[MEM_CATEGORIES] = {
+   "SOURCE", "EXPRESSIONS", "STATEMENTS", "VARIABLES"
+};
+
+void chargeMemory(MemoryCategory category, size_t bytes) {
+   if (memoryLimit != 0
+       && (memoryTotal > memoryLimit || bytes > memoryLimit - memoryTotal)) {
+      error("OUT OF MEMORY");
+   }
+   memoryUsed[category] += bytes;
+   memoryTotal += bytes;
+}
+
+void releaseMemory(MemoryCategory category, size_t bytes) {
+   memoryUsed[category] -= bytes;
+   memoryTotal -= bytes;
+}
+
+size_t getMemoryUsed(MemoryCategory category) {
+   if (category == MEM_CATEGORIES) return memoryTotal;
+   return memoryUsed[category];
+}
+
+void setMemoryLimit(size_t bytes) {
+   memoryLimit = bytes;
+}
+
+size_t getMemoryLimit() {
+   return memoryLimit;
+}
+
+const char *getMemoryCategoryName(MemoryCategory category) {
+   return CATEGORY_NAMES[category];
+}
@@ -0,0 +1,81 @@
+/*
+ * File: memusage.h
+ * ----------------
+ * This interface exports functions that account for the memory used by
+ * an interpreter session and enforce an optional limit on it.
+ */
+
+#ifndef _memusage_h
+#define _memusage_h
+
+#include <cstddef>
+
+/*
+ * Type: MemoryCategory
+ * --------------------
+ * The kinds of storage that are accounted for separately.
+ */
+
+enum MemoryCategory {
+   MEM_SOURCE,         /* Program source text and line records        */
+   MEM_EXPRESSIONS,    /* Live expression nodes                       */
+   MEM_STATEMENTS,     /* Statement objects                           */
+   MEM_VARIABLES,      /* Variable pages and interned variable names  */
+   MEM_CATEGORIES      /* The number of categories                    */
+};
+
+/*
+ * Function: chargeMemory
+ * Usage: chargeMemory(category, bytes);
+ * -------------------------------------
+ * Records that bytes more are about to be used for category.  If this
+ * would take the total above the limit, this function calls error with
+ * the message "OUT OF MEMORY" and records nothing, so callers charge
+ * before they allocate or change anything.
+ */
+
+void chargeMemory(MemoryCategory category, size_t bytes);
+
+/*
+ * Function: releaseMemory
+ * Usage: releaseMemory(category, bytes);
+ * --------------------------------------
+ * Records that bytes previously charged to category have been freed.
+ */
+
+void releaseMemory(MemoryCategory category, size_t bytes);
+
+/*
+ * Function: getMemoryUsed
+ * Usage: size_t bytes = getMemoryUsed(category);
+ * ----------------------------------------------
+ * Returns the bytes currently charged to category, or to all categories
+ * when category is MEM_CATEGORIES.
+ */
+
+size_t getMemoryUsed(MemoryCategory category);
+
+/*
+ * Functions: setMemoryLimit, getMemoryLimit
+ * Usage: setMemoryLimit(bytes);
+ *        size_t bytes = getMemoryLimit();
+ * ---------------------------------------
+ * Sets or returns the largest total that chargeMemory allows.  A limit
+ * of 0, the initial setting, means there is no limit.  Lowering the
+ * limit below the current total frees nothing; it only makes the next
+ * charge fail.
+ */
+
+void setMemoryLimit(size_t bytes);
+size_t getMemoryLimit();
+
+/*
+ * Function: getMemoryCategoryName
+ * Usage: const char *name = getMemoryCategoryName(category);
+ * ----------------------------------------------------------
+ * Returns the name that MEM prints for category.
+ */
+
+const char *getMemoryCategoryName(MemoryCategory category);
+
+#endif
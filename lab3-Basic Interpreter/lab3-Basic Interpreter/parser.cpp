@@ -5,6 +5,7 @@
  */
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "exp.h"
@@ -15,115 +16,312 @@
 #include "../StanfordCPPLib/tokenscanner.h"
 using namespace std;
 
+/*
+ * Implementation notes: typed tokens
+ * ----------------------------------
+ * The scanner hands out tokens as strings.  A TokenStream reads them
+ * one at a time and classifies each token once, as it is read, into a
+ * TokenKind and, for the operators the grammar uses, an Operator code.
+ * The parser then looks only at those codes, so choosing a rule or the
+ * precedence of an operator costs an array index rather than a string
+ * comparison.  The single token of lookahead the Pratt loop needs is
+ * kept in the stream instead of being pushed back onto the scanner.
+ * When the stream goes away, a token it has read but not consumed is
+ * returned to the scanner, so the public functions leave the scanner
+ * where they always did.
+ */
+
+enum TokenKind { END_TOKEN, NUMBER_TOKEN, WORD_TOKEN, OPERATOR_TOKEN };
+
+enum Operator {
+   NO_OP, ASSIGN_OP, LESS_OP, GREATER_OP, PLUS_OP, MINUS_OP,
+   TIMES_OP, DIVIDE_OP, LPAREN_OP, RPAREN_OP, OPERATOR_COUNT
+};
+
+struct Token {
+   TokenKind kind;
+   Operator op;                     /* NO_OP unless a known operator */
+   string text;
+};
+
+/*
+ * The comparison operators share the lowest level with =, which lets
+ * the IF statement read its left operand with readE(ts, 1) and stop at
+ * the comparison.  Anything that is not a binary operator, including
+ * every token longer than one character, has precedence 0.
+ */
+
+static const int OPERATOR_PRECEDENCE[OPERATOR_COUNT] = {
+   0, 1, 1, 1, 2, 2, 3, 3, 0, 0
+};
+
+static const char *const OPERATOR_NAMES[OPERATOR_COUNT] = {
+   "", "=", "<", ">", "+", "-", "*", "/", "(", ")"
+};
+
+static Operator operatorFor(const string & text) {
+   if (text.length() != 1) return NO_OP;
+   switch (text[0]) {
+    case '=': return ASSIGN_OP;
+    case '<': return LESS_OP;
+    case '>': return GREATER_OP;
+    case '+': return PLUS_OP;
+    case '-': return MINUS_OP;
+    case '*': return TIMES_OP;
+    case '/': return DIVIDE_OP;
+    case '(': return LPAREN_OP;
+    case ')': return RPAREN_OP;
+   }
+   return NO_OP;
+}
+
+class TokenStream {
+
+public:
+
+   TokenStream(TokenScanner & scanner) : scanner(scanner) {
+      buffered = false;
+   }
+
+   ~TokenStream() {
+      if (buffered && lookahead.kind != END_TOKEN) {
+         scanner.saveToken(lookahead.text);
+      }
+   }
+
+   const Token & peek() {
+      if (!buffered) {
+         lookahead.text = scanner.nextToken();
+         lookahead.op = NO_OP;
+         if (lookahead.text.empty()) {
+            lookahead.kind = END_TOKEN;
+         } else {
+            TokenType type = scanner.getTokenType(lookahead.text);
+            if (type == NUMBER) {
+               lookahead.kind = NUMBER_TOKEN;
+            } else if (type == WORD) {
+               lookahead.kind = WORD_TOKEN;
+            } else {
+               lookahead.kind = OPERATOR_TOKEN;
+               lookahead.op = operatorFor(lookahead.text);
+            }
+         }
+         buffered = true;
+      }
+      return lookahead;
+   }
+
+   Token next() {
+      peek();
+      buffered = false;
+      return std::move(lookahead);
+   }
+
+   void skip() {
+      peek();
+      buffered = false;
+   }
+
+   void putBack(Token & token) {
+      lookahead = std::move(token);
+      buffered = true;
+   }
+
+private:
+
+   TokenScanner & scanner;
+   Token lookahead;
+   bool buffered;
+
+};
+
+static Expression *parseExp(TokenStream & ts);
+static Expression *readE(TokenStream & ts, int prec);
+static Expression *readT(TokenStream & ts);
+
+/*
+ * Implementation notes: parseExp, readE, readT, precedence
+ * --------------------------------------------------------
+ * The public functions wrap the scanner in a TokenStream and hand the
+ * work to the versions below, which never see the scanner.
+ */
+
+Expression *parseExp(TokenScanner & scanner) {
+   TokenStream ts(scanner);
+   return parseExp(ts);
+}
+
+Expression *readE(TokenScanner & scanner, int prec) {
+   TokenStream ts(scanner);
+   return readE(ts, prec);
+}
+
+Expression *readT(TokenScanner & scanner) {
+   TokenStream ts(scanner);
+   return readT(ts);
+}
+
+int precedence(const string & token) {
+   return OPERATOR_PRECEDENCE[operatorFor(token)];
+}
+
 /*
  * Implementation notes: parseExp
  * ------------------------------
  * This code just reads an expression and then checks for extra tokens.
  */
 
-Expression *parseExp(TokenScanner & scanner) {
-   Expression *exp = readE(scanner);
-   if (scanner.hasMoreTokens()) {
-      error("parseExp: Found extra token: " + scanner.nextToken());
+static Expression *parseExp(TokenStream & ts) {
+   unique_ptr<Expression> exp(readE(ts, 0));
+   if (ts.peek().kind != END_TOKEN) {
+      error("parseExp: Found extra token: " + ts.peek().text);
    }
-   return exp;
+   return exp.release();
 }
 
 /*
  * Implementation notes: readE
- * Usage: exp = readE(scanner, prec);
- * ----------------------------------
- * This version of readE uses precedence to resolve the ambiguity in
- * the grammar.  At each recursive level, the parser reads operators and
- * subexpressions until it finds an operator whose precedence is greater
- * than the prevailing one.  When a higher-precedence operator is found,
- * readE calls itself recursively to read in that subexpression as a unit.
+ * Usage: exp = readE(ts, prec);
+ * -----------------------------
+ * This version of readE is a Pratt parser.  It reads a prefix term with
+ * readT and then, for as long as the next token is an infix operator
+ * that binds more tightly than prec, reads the right operand by calling
+ * itself with that operator's precedence.  Because the recursive call
+ * stops at operators of equal precedence, every binary operator is left
+ * associative.  The loop works from the Operator code of the lookahead
+ * token, so it makes no string comparisons and pushes nothing back.
+ * Subtrees are held in unique_ptrs until a node owns them, so that an
+ * error partway through frees whatever has been built.
  */
 
-Expression *readE(TokenScanner & scanner, int prec) {
-   Expression *exp = readT(scanner);
-   string token;
+static Expression *readE(TokenStream & ts, int prec) {
+   unique_ptr<Expression> exp(readT(ts));
    while (true) {
-      token = scanner.nextToken();
-      int newPrec = precedence(token);
+      Operator op = ts.peek().op;
+      int newPrec = OPERATOR_PRECEDENCE[op];
       if (newPrec <= prec) break;
-      Expression *rhs = readE(scanner, newPrec);
-      exp = new CompoundExp(token, exp, rhs);
+      ts.skip();
+      unique_ptr<Expression> rhs(readE(ts, newPrec));
+      Expression *node = new CompoundExp(OPERATOR_NAMES[op], exp.get(),
+                                         rhs.get());
+      exp.release();
+      rhs.release();
+      exp.reset(node);
    }
-   scanner.saveToken(token);
-   return exp;
+   return exp.release();
 }
 
 /*
  * Implementation notes: readT
  * ---------------------------
  * This function scans a term, which is either an integer, an identifier,
- * or a parenthesized subexpression.
+ * a parenthesized subexpression, or a unary minus applied to a term.
+ * The operand of unary minus is read at UNARY_PRECEDENCE, so -a * b
+ * parses as (-a) * b.  Negated constants are folded into a single
+ * ConstantExp; any other operand is represented as (0 - operand).
  */
 
-Expression *readT(TokenScanner & scanner) {
-   string token = scanner.nextToken();
-   TokenType type = scanner.getTokenType(token);
-   if (type == WORD) return new IdentifierExp(token);
-   if (type == NUMBER) return new ConstantExp(stringToInteger(token));
-   if (token != "(") error("Illegal term in expression");
-   Expression *exp = readE(scanner);
-   if (scanner.nextToken() != ")") {
+static Expression *readT(TokenStream & ts) {
+   Token token = ts.next();
+   if (token.kind == WORD_TOKEN) return new IdentifierExp(token.text);
+   if (token.kind == NUMBER_TOKEN) {
+      return new ConstantExp(stringToInteger(token.text));
+   }
+   if (token.op == MINUS_OP) {
+      unique_ptr<Expression> operand(readE(ts, UNARY_PRECEDENCE));
+      if (operand->getType() == CONSTANT) {
+         int value = ((ConstantExp *) operand.get())->getValue();
+         operand.reset();
+         return new ConstantExp(-value);
+      }
+      unique_ptr<Expression> zero(new ConstantExp(0));
+      Expression *node = new CompoundExp("-", zero.get(), operand.get());
+      zero.release();
+      operand.release();
+      return node;
+   }
+   if (token.op != LPAREN_OP) error("Illegal term in expression");
+   unique_ptr<Expression> exp(readE(ts, 0));
+   if (ts.next().op != RPAREN_OP) {
       error("Unbalanced parentheses in expression");
    }
-   return exp;
+   return exp.release();
 }
 
-/*
- * Implementation notes: precedence
- * --------------------------------
- * This function checks the token against each of the defined operators
- * and returns the appropriate precedence value.
- */
-
-int precedence(string token) {
-   if (token == "=") return 1;
-   if (token == "+" || token == "-") return 2;
-   if (token == "*" || token == "/") return 3;
-   return 0;
-}
-
 /*
  * Implementation notes: parseState
  * --------------------------------
  * This code just reads an statement and parse it as different type.
- * If no statement be parsed, return NULL.
+ * If no statement be parsed, return NULL.  The line is read through a
+ * TokenStream, so the expressions in it are parsed from typed tokens.
+ * The expressions are held in unique_ptrs until the statement that owns
+ * them has been constructed, since the LET constructor can reject its
+ * variable name.
  */
 
 Statement * parseState(TokenScanner & scanner)
 {
-	string test = scanner.nextToken();
+	TokenStream ts(scanner);
+	Token first = ts.next();
+	const string & test = first.text;
 	if (test == "REM" )
 		return new REMSTATE();
 	if (test == "LET") {
-		string var = scanner.nextToken();
-		if (scanner.nextToken() != "=")
+		string var = ts.next().text;
+		if (ts.next().op != ASSIGN_OP)
 			error("need = after variable");
-		Expression *exp = parseExp(scanner);
-		return new LETState(var, exp);
+		unique_ptr<Expression> exp(parseExp(ts));
+		Statement *stmt = new LETState(var, exp.get());
+		exp.release();
+		return stmt;
+	}
+	if (test == "PRINT") {
+		unique_ptr<Expression> exp(parseExp(ts));
+		Statement *stmt = new PRINTState(exp.get());
+		exp.release();
+		return stmt;
 	}
-	if (test == "PRINT")
-		return new PRINTState(parseExp(scanner));
 	if (test == "INPUT")
-		return new INPUTState(scanner.nextToken());
+		return new INPUTState(ts.next().text);
 	if (test == "END")
 		return new ENDState();
 	if (test == "GOTO")
-		return new GOTOState(stoi(scanner.nextToken()));
+		return new GOTOState(stringToInteger(ts.next().text));
 	if (test == "IF") {
-		Expression *exp1 = readE(scanner, 1);
-		char cmp = scanner.nextToken()[0];
-		Expression *exp2 = readE(scanner);
-		if (scanner.nextToken() != "THEN")
+		unique_ptr<Expression> exp1(readE(ts, 1));
+		char cmp = ts.next().text[0];
+		unique_ptr<Expression> exp2(readE(ts, 0));
+		if (ts.next().text != "THEN")
 			error("IF_THEN statement is illegal");
-		return new IFTHENState(exp1,cmp,exp2,stoi(scanner.nextToken()));
+		int target = stringToInteger(ts.next().text);
+		Statement *stmt = new IFTHENState(exp1.get(), cmp, exp2.get(), target);
+		exp1.release();
+		exp2.release();
+		return stmt;
 	}
-	scanner.saveToken(test);
+	ts.putBack(first);
 	return NULL;
 }
 
+
+/*
+ * Implementation notes: the ParseContext class
+ * --------------------------------------------
+ * The scanner is configured once in the constructor.  TokenScanner's
+ * setInput keeps that configuration and rewinds its existing string
+ * stream, so reset costs no more than copying the new line.
+ */
+
+ParseContext::ParseContext() {
+   scanner.ignoreWhitespace();
+   scanner.scanNumbers();
+}
+
+TokenScanner & ParseContext::reset(const string & line) {
+   scanner.setInput(line);
+   return scanner;
+}
+
+TokenScanner & ParseContext::getScanner() {
+   return scanner;
+}
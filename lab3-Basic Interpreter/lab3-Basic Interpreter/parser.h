@@ -39,7 +39,7 @@ Expression *readE(TokenScanner & scanner, int prec = 0);
  * Usage: Expression *exp = readT(scanner);
  * ----------------------------------------
  * Returns the next individual term, which is either a constant, an
- * identifier, or a parenthesized subexpression.
+ * identifier, a parenthesized subexpression, or a negated term.
  */
 
 Expression *readT(TokenScanner & scanner);
@@ -49,10 +49,20 @@ Expression *readT(TokenScanner & scanner);
  * Usage: int prec = precedence(token);
  * ------------------------------------
  * Returns the precedence of the specified operator token.  If the token
- * is not an operator, precedence returns 0.
+ * is not an operator, precedence returns 0.  The binary operators, from
+ * loosest to tightest, are = < > (1), + - (2) and * / (3).
  */
 
-int precedence(std::string token);
+int precedence(const std::string & token);
+
+/*
+ * Constant: UNARY_PRECEDENCE
+ * --------------------------
+ * The precedence at which the operand of a unary minus is read.  It is
+ * higher than that of any binary operator.
+ */
+
+const int UNARY_PRECEDENCE = 4;
 
 /*
 * Function: parseState
@@ -65,4 +75,53 @@ int precedence(std::string token);
 */
 
 Statement *parseState(TokenScanner &scanner);
+
+/*
+ * Class: ParseContext
+ * -------------------
+ * This class holds the parsing machinery that outlives a single line:
+ * a TokenScanner configured once to ignore whitespace and scan numbers.
+ * The interpreter session owns one ParseContext and resets it for each
+ * line it reads, so the scanner and its stream buffers are reused
+ * rather than rebuilt for every line.
+ */
+
+class ParseContext {
+
+public:
+
+/*
+ * Constructor: ParseContext
+ * Usage: ParseContext context;
+ * ----------------------------
+ * Creates a parse context whose scanner is ready for BASIC input.
+ */
+
+   ParseContext();
+
+/*
+ * Method: reset
+ * Usage: TokenScanner & scanner = context.reset(line);
+ * ----------------------------------------------------
+ * Points the scanner at a new line of input, discarding anything left
+ * over from the previous line, and returns the scanner.
+ */
+
+   TokenScanner & reset(const std::string & line);
+
+/*
+ * Method: getScanner
+ * Usage: TokenScanner & scanner = context.getScanner();
+ * -----------------------------------------------------
+ * Returns the scanner for the line most recently passed to reset.
+ */
+
+   TokenScanner & getScanner();
+
+private:
+
+   TokenScanner scanner;
+
+};
+
 #endif
@@ -8,63 +8,521 @@
  * the performance guarantees specified in the assignment.
  */
 
+#include <cctype>
+#include <climits>
+#include <iostream>
 #include <string>
+#include <string_view>
+#include "memusage.h"
 #include "program.h"
 #include "statement.h"
+
+#include "../StanfordCPPLib/error.h"
+#include "../StanfordCPPLib/strlib.h"
 using namespace std;
 
+/* Dead pool bytes below this count never trigger a compaction */
+
+static const size_t COMPACT_THRESHOLD = 64 * 1024;
+
+/* The bytes charged for each line besides its text: its map node */
+
+static const size_t LINE_RECORD_BYTES = sizeof(ProgramLine) + 4 * sizeof(void *);
+
 Program::Program() {
-   // Replace this stub with your own code
+	deadText = 0;
+	poolInOrder = true;
+	indexValid = false;
+	indexDense = true;
+	indexBase = 0;
+	indexBytes = 0;
+	originFileHash = 0;
+	originTextHash = 0;
 }
 
 Program::~Program() {
-   // Replace this stub with your own code
+	clear();
 }
 
 void Program::clear() {
-	Sourceline.clear();
-	ParsedStatement.clear();
+	releaseMemory(MEM_SOURCE, sourcePool.length() + lines.size() * LINE_RECORD_BYTES + indexBytes);
+	indexBytes = 0;
+	for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++)
+		delete it->second.stmt;
+	lines.clear();
+	dirtyLines.clear();
+	referrers.clear();
+	sourcePool.clear();
+	deadText = 0;
+	poolInOrder = true;
+	indexValid = false;
+	denseIndex.clear();
+	sparseIndex.clear();
+	originFile.clear();
+}
+
+/*
+ * Implementation notes: swap
+ * --------------------------
+ * The memory charged for each program stays charged while it exists,
+ * so swapping changes nothing in the accounting.
+ */
+
+void Program::swap(Program & other) {
+	lines.swap(other.lines);
+	dirtyLines.swap(other.dirtyLines);
+	referrers.swap(other.referrers);
+	sourcePool.swap(other.sourcePool);
+	std::swap(deadText, other.deadText);
+	std::swap(poolInOrder, other.poolInOrder);
+	std::swap(indexValid, other.indexValid);
+	std::swap(indexDense, other.indexDense);
+	std::swap(indexBase, other.indexBase);
+	std::swap(indexBytes, other.indexBytes);
+	denseIndex.swap(other.denseIndex);
+	sparseIndex.swap(other.sparseIndex);
+	originFile.swap(other.originFile);
+	std::swap(originFileHash, other.originFileHash);
+	std::swap(originTextHash, other.originTextHash);
+}
+
+/*
+ * Implementation notes: checkRoomFor
+ * ----------------------------------
+ * The bound is what addSourceLine would charge if every line were new.
+ * It is charged and released again at once, which checks it against
+ * the limit without keeping it.
+ */
+
+void Program::checkRoomFor(size_t lineCount, size_t textBytes) {
+	size_t bytes = textBytes + lineCount * (1 + LINE_RECORD_BYTES);
+	chargeMemory(MEM_SOURCE, bytes);
+	releaseMemory(MEM_SOURCE, bytes);
+}
+
+void Program::setOrigin(const string & filename, unsigned long long fileHash,
+                        unsigned long long textHash) {
+	originFile = filename;
+	originFileHash = fileHash;
+	originTextHash = textHash;
+}
+
+string Program::getOriginFile() {
+	return originFile;
 }
 
+unsigned long long Program::getOriginFileHash() {
+	return originFileHash;
+}
+
+unsigned long long Program::getOriginTextHash() {
+	return originTextHash;
+}
+
+/*
+ * Implementation notes: addSourceLine, removeSourceLine
+ * -----------------------------------------------------
+ * The next links of the neighbouring lines are patched directly, and so
+ * are the target links of every line recorded in referrers as jumping
+ * to the line being added or removed.  Lines whose own statement
+ * changes are marked dirty and are relinked by the next call to link.
+ * The new text, and the record of a new line, are charged to MEM_SOURCE
+ * before anything changes.
+ */
+
 void Program::addSourceLine(int lineNumber, string line) {
-	if (Sourceline.find(lineNumber)!=Sourceline.end())
-		ParsedStatement.erase(lineNumber);
-	Sourceline[lineNumber] = line;
+	map<int, ProgramLine>::iterator it = lines.find(lineNumber);
+	bool isNew = (it == lines.end());
+	chargeMemory(MEM_SOURCE, line.length() + 1 + (isNew ? LINE_RECORD_BYTES : 0));
+	if (!isNew) {
+		ProgramLine & existing = it->second;
+		unlinkJump(existing);
+		delete existing.stmt;
+		existing.stmt = NULL;
+		deadText += existing.sourceLength + 1;
+		poolInOrder = false;
+		storeSource(existing, line);
+		dirtyLines.insert(lineNumber);
+		return;
+	}
+	it = lines.insert(make_pair(lineNumber, ProgramLine())).first;
+	ProgramLine & added = it->second;
+	added.lineNumber = lineNumber;
+	storeSource(added, line);
+	added.stmt = NULL;
+	added.target = NULL;
+	added.targetNumber = -1;
+	map<int, ProgramLine>::iterator after = it;
+	after++;
+	added.next = (after == lines.end()) ? NULL : &after->second;
+	if (added.next != NULL)
+		poolInOrder = false;
+	if (it != lines.begin()) {
+		map<int, ProgramLine>::iterator before = it;
+		before--;
+		before->second.next = &added;
+	}
+	map<int, set<int> >::iterator refs = referrers.find(lineNumber);
+	if (refs != referrers.end()) {
+		for (set<int>::iterator src = refs->second.begin(); src != refs->second.end(); src++)
+			findLine(*src)->target = &added;
+	}
+	indexLine(lineNumber, &added);
+	dirtyLines.insert(lineNumber);
 }
 
 void Program::removeSourceLine(int lineNumber) {
-	if (Sourceline.find(lineNumber)==Sourceline.end())
+	map<int, ProgramLine>::iterator it = lines.find(lineNumber);
+	if (it == lines.end())
 		return;
-	Sourceline.erase(lineNumber);
-	ParsedStatement.erase(lineNumber);
+	ProgramLine & removed = it->second;
+	unlinkJump(removed);
+	if (it != lines.begin()) {
+		map<int, ProgramLine>::iterator before = it;
+		before--;
+		before->second.next = removed.next;
+	}
+	map<int, set<int> >::iterator refs = referrers.find(lineNumber);
+	if (refs != referrers.end()) {
+		for (set<int>::iterator src = refs->second.begin(); src != refs->second.end(); src++)
+			findLine(*src)->target = NULL;
+	}
+	indexLine(lineNumber, NULL);
+	dirtyLines.erase(lineNumber);
+	deadText += removed.sourceLength + 1;
+	poolInOrder = false;
+	delete removed.stmt;
+	lines.erase(it);
+	releaseMemory(MEM_SOURCE, LINE_RECORD_BYTES);
+	if (deadText > COMPACT_THRESHOLD && deadText > sourcePool.length() / 2)
+		compactSource();
 }
 
 string Program::getSourceLine(int lineNumber) {
-	if (Sourceline.find(lineNumber) != Sourceline.end())
-		return Sourceline[lineNumber];
-	return "";    
+	ProgramLine *line = findLine(lineNumber);
+	if (line != NULL)
+		return sourcePool.substr(line->sourceOffset, line->sourceLength);
+	return "";
+}
+
+/*
+ * Implementation notes: listSource
+ * --------------------------------
+ * Once the pool has been compacted it is exactly the listing, newlines
+ * included, so LIST is a single write of the whole pool.
+ */
+
+void Program::listSource(ostream & os) {
+	if (!poolInOrder)
+		compactSource();
+	os.write(sourcePool.data(), sourcePool.length());
+	os.flush();
 }
 
 void Program::setParsedStatement(int lineNumber, Statement *stmt) {
-	if (Sourceline.find(lineNumber) == Sourceline.end())
+	ProgramLine *found = findLine(lineNumber);
+	if (found == NULL)
 		error("no line exist in program");
-	ParsedStatement[lineNumber] = stmt;
+	ProgramLine & line = *found;
+	if (line.stmt != stmt) {
+		unlinkJump(line);
+		delete line.stmt;
+		line.stmt = stmt;
+		dirtyLines.insert(lineNumber);
+	}
 }
 
 Statement *Program::getParsedStatement(int lineNumber) {
-	if (ParsedStatement.find(lineNumber)!=ParsedStatement.end())
-		return ParsedStatement[lineNumber];
-	return NULL;  
+	ProgramLine *line = findLine(lineNumber);
+	if (line != NULL)
+		return line->stmt;
+	return NULL;
 }
 
 int Program::getFirstLineNumber() {
-	if (Sourceline.empty())
+	if (lines.empty())
 		return -1;
-	return Sourceline.begin()->first;
+	return lines.begin()->first;
 }
 
 int Program::getNextLineNumber(int lineNumber) {
-	if ((--Sourceline.end())->first == lineNumber)
+	ProgramLine *line = findLine(lineNumber);
+	if (line == NULL || line->next == NULL)
 		return -1;
-	return (++Sourceline.find(lineNumber))->first;
+	return line->next->lineNumber;
+}
+
+/*
+ * Implementation notes: link
+ * --------------------------
+ * Each dirty line records its jump target in referrers, whether or not
+ * the target exists yet, so that adding the target later patches the
+ * jump without revisiting this line.
+ */
+
+void Program::link() {
+	if (!indexValid)
+		rebuildIndex();
+	for (set<int>::iterator dirty = dirtyLines.begin(); dirty != dirtyLines.end(); dirty++) {
+		ProgramLine & line = *findLine(*dirty);
+		unlinkJump(line);
+		if (line.stmt == NULL)
+			continue;
+		int targetNumber = -1;
+		if (line.stmt->getType() == GOTO)
+			targetNumber = ((GOTOState *) line.stmt)->getLineNumber();
+		else if (line.stmt->getType() == IFTHEN)
+			targetNumber = ((IFTHENState *) line.stmt)->getLineNumber();
+		if (targetNumber == -1)
+			continue;
+		line.targetNumber = targetNumber;
+		referrers[targetNumber].insert(line.lineNumber);
+		line.target = findLine(targetNumber);
+	}
+	dirtyLines.clear();
+}
+
+ProgramLine *Program::getFirstLine() {
+	if (lines.empty())
+		return NULL;
+	return &lines.begin()->second;
+}
+
+ProgramLine *Program::getLine(int lineNumber) {
+	return findLine(lineNumber);
+}
+
+/*
+ * Implementation notes: renumber
+ * ------------------------------
+ * After link, every jump to an existing line holds a pointer to that
+ * line, so once each line has been given its new number a jump finds
+ * its new target through the pointer and no old-to-new table or search
+ * is needed.  The source pool is rebuilt in line order with the new
+ * numbers, which also compacts it.  The map nodes are then moved into
+ * a fresh map under their new keys; node handles keep the nodes where
+ * they are, so every next and target pointer stays valid, and since the
+ * keys arrive in order each insertion takes constant time.  Only the
+ * referrers table is rebuilt with logarithmic inserts.  A jump to a
+ * line that does not exist has nothing to follow, and one of the new
+ * numbers could turn it into a jump to an unrelated line, so renumber
+ * refuses to run while the program has one.  Since the line number and
+ * the target of a line can each grow by at most MAX_DIGITS characters,
+ * that much is charged before the program changes and the unused part
+ * is released after.  The new numbers are counted in a long long, since
+ * the check above bounds only the last number assigned and not the step
+ * taken past it.
+ */
+
+static const size_t MAX_DIGITS = 10;
+
+void Program::renumber(int start, int step) {
+	if (start < 0 || step <= 0)
+		error("RENUM: start must not be negative and step must be positive");
+	if (!lines.empty() && start + (long long) step * (lines.size() - 1) > INT_MAX)
+		error("RENUM: line numbers would be too large");
+	link();
+	for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++) {
+		ProgramLine & line = it->second;
+		if (line.targetNumber != -1 && line.target == NULL)
+			error("RENUM: line " + integerToString(line.lineNumber)
+			      + " jumps to missing line " + integerToString(line.targetNumber));
+	}
+	size_t oldLength = sourcePool.length();
+	size_t growth = lines.size() * 2 * MAX_DIGITS;
+	chargeMemory(MEM_SOURCE, growth);
+	long long number = start;
+	for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++) {
+		it->second.lineNumber = (int) number;
+		number += step;
+	}
+	string packed;
+	packed.reserve(sourcePool.length() - deadText);
+	referrers.clear();
+	for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++) {
+		ProgramLine & line = it->second;
+		string_view text(sourcePool.data() + line.sourceOffset, line.sourceLength);
+		size_t head = 0;
+		while (head < text.length() && isspace((unsigned char) text[head]))
+			head++;
+		size_t body = head;
+		while (body < text.length() && isdigit((unsigned char) text[body]))
+			body++;
+		size_t tail = text.length();
+		if (line.target != NULL) {
+			int newTarget = line.target->lineNumber;
+			if (line.stmt->getType() == GOTO)
+				((GOTOState *) line.stmt)->setLineNumber(newTarget);
+			else
+				((IFTHENState *) line.stmt)->setLineNumber(newTarget);
+			line.targetNumber = newTarget;
+			size_t end = text.length();
+			while (end > body && isspace((unsigned char) text[end - 1]))
+				end--;
+			tail = end;
+			while (tail > body && isdigit((unsigned char) text[tail - 1]))
+				tail--;
+			if (tail == end)
+				tail = text.length();
+		}
+		size_t offset = packed.length();
+		packed.append(text.substr(0, head));
+		packed += integerToString(line.lineNumber);
+		packed.append(text.substr(body, tail - body));
+		if (tail < text.length()) {
+			size_t end = tail;
+			while (end < text.length() && isdigit((unsigned char) text[end]))
+				end++;
+			packed += integerToString(line.targetNumber);
+			packed.append(text.substr(end));
+		}
+		line.sourceOffset = offset;
+		line.sourceLength = packed.length() - offset;
+		packed += '\n';
+		if (line.targetNumber != -1)
+			referrers[line.targetNumber].insert(line.lineNumber);
+	}
+	sourcePool.swap(packed);
+	releaseMemory(MEM_SOURCE, oldLength + growth - sourcePool.length());
+	deadText = 0;
+	poolInOrder = true;
+	map<int, ProgramLine> renumbered;
+	while (!lines.empty()) {
+		map<int, ProgramLine>::node_type node = lines.extract(lines.begin());
+		node.key() = node.mapped().lineNumber;
+		renumbered.insert(renumbered.end(), std::move(node));
+	}
+	lines.swap(renumbered);
+	indexValid = false;
+}
+
+/*
+ * Implementation notes: storeSource, compactSource
+ * ------------------------------------------------
+ * Source text is appended to a single pool, each line followed by a
+ * newline, and a line refers to its text by offset and length.  Text
+ * that is replaced or removed stays in the pool as dead bytes until
+ * compactSource copies the live lines into a fresh pool in line order.
+ * Removal compacts once dead bytes make up more than half of the pool,
+ * and LIST compacts whenever the pool is not already in line order.
+ */
+
+void Program::storeSource(ProgramLine & line, const string & text) {
+	line.sourceOffset = sourcePool.length();
+	line.sourceLength = text.length();
+	sourcePool += text;
+	sourcePool += '\n';
+	if (deadText > COMPACT_THRESHOLD && deadText > sourcePool.length() / 2)
+		compactSource();
+}
+
+void Program::compactSource() {
+	releaseMemory(MEM_SOURCE, deadText);
+	string packed;
+	packed.reserve(sourcePool.length() - deadText);
+	for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++) {
+		ProgramLine & line = it->second;
+		size_t offset = packed.length();
+		packed.append(sourcePool, line.sourceOffset, line.sourceLength + 1);
+		line.sourceOffset = offset;
+	}
+	sourcePool.swap(packed);
+	deadText = 0;
+	poolInOrder = true;
+}
+
+/*
+ * Implementation notes: unlinkJump
+ * --------------------------------
+ * Removes the line from the referrers entry of its current target and
+ * clears its jump link.
+ */
+
+void Program::unlinkJump(ProgramLine & line) {
+	if (line.targetNumber != -1) {
+		map<int, set<int> >::iterator refs = referrers.find(line.targetNumber);
+		refs->second.erase(line.lineNumber);
+		if (refs->second.empty())
+			referrers.erase(refs);
+	}
+	line.target = NULL;
+	line.targetNumber = -1;
+}
+
+/*
+ * Implementation notes: findLine, indexLine, rebuildIndex
+ * -------------------------------------------------------
+ * Lines are looked up through an index kept beside the map.  When the
+ * line numbers are reasonably dense, the index is a direct array from
+ * line number to line; when they are sparse, it is a hash table.  Edits
+ * keep the index current where that is cheap: any change to the hash
+ * table, or a change inside the range of the array.  A line added
+ * outside the array's range invalidates the index instead of growing
+ * it, so loading a program line by line never copies the array, and
+ * lookups fall back to the map until the next link rebuilds the index.
+ */
+
+static const int DENSE_SLACK = 1024;
+static const size_t SPARSE_ENTRY_BYTES = 2 * sizeof(void *) + sizeof(int) + sizeof(ProgramLine *);
+
+ProgramLine *Program::findLine(int lineNumber) {
+	if (indexValid) {
+		if (indexDense) {
+			unsigned int slot = (unsigned int) (lineNumber - indexBase);
+			return (slot < denseIndex.size()) ? denseIndex[slot] : NULL;
+		}
+		unordered_map<int, ProgramLine *>::iterator it = sparseIndex.find(lineNumber);
+		return (it == sparseIndex.end()) ? NULL : it->second;
+	}
+	map<int, ProgramLine>::iterator it = lines.find(lineNumber);
+	return (it == lines.end()) ? NULL : &it->second;
+}
+
+void Program::indexLine(int lineNumber, ProgramLine *line) {
+	if (!indexValid)
+		return;
+	if (!indexDense) {
+		if (line == NULL)
+			sparseIndex.erase(lineNumber);
+		else
+			sparseIndex[lineNumber] = line;
+		return;
+	}
+	unsigned int slot = (unsigned int) (lineNumber - indexBase);
+	if (slot < denseIndex.size())
+		denseIndex[slot] = line;
+	else if (line != NULL)
+		indexValid = false;
+}
+
+/*
+ * The array is used when it would have no more than two slots per line
+ * plus a fixed slack; otherwise the lines go into the hash table.  The
+ * index is charged to MEM_SOURCE.
+ */
+
+void Program::rebuildIndex() {
+	indexValid = false;
+	denseIndex.clear();
+	sparseIndex.clear();
+	releaseMemory(MEM_SOURCE, indexBytes);
+	indexBytes = 0;
+	long long first = lines.empty() ? 0 : lines.begin()->first;
+	long long range = lines.empty() ? 0 : lines.rbegin()->first - first + 1;
+	indexDense = (range <= 2 * (long long) lines.size() + DENSE_SLACK);
+	size_t bytes = indexDense ? size_t(range) * sizeof(ProgramLine *)
+	                          : lines.size() * SPARSE_ENTRY_BYTES;
+	chargeMemory(MEM_SOURCE, bytes);
+	indexBytes = bytes;
+	indexValid = true;
+	if (indexDense) {
+		indexBase = int(first);
+		denseIndex.assign(size_t(range), NULL);
+		for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++)
+			denseIndex[it->first - indexBase] = &it->second;
+	} else {
+		sparseIndex.reserve(lines.size());
+		for (map<int, ProgramLine>::iterator it = lines.begin(); it != lines.end(); it++)
+			sparseIndex[it->first] = &it->second;
+	}
 }
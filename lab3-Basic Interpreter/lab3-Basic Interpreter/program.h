@@ -8,11 +8,38 @@
 #ifndef _program_h
 #define _program_h
 
+#include <iostream>
 #include <string>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 #include "statement.h"
 using namespace std;
 
+/*
+ * Type: ProgramLine
+ * -----------------
+ * This structure holds one line of a program together with the links
+ * that the interpreter follows when it runs the program: the next line
+ * in sequence and, for GOTO and IF_THEN statements, the line that the
+ * statement jumps to.  The next field is always current.  The target
+ * field is brought up to date by Program::link, and is NULL when the
+ * line is not a jump or jumps to a line that does not exist.  The text
+ * of the line lives in the program's source pool; use getSourceLine to
+ * read it.
+ */
+
+struct ProgramLine {
+   int lineNumber;              /* The number of this line             */
+   size_t sourceOffset;         /* The start of its text in the pool   */
+   size_t sourceLength;         /* The length of its text              */
+   Statement *stmt;             /* The parsed statement, or NULL       */
+   ProgramLine *next;           /* The following line, or NULL         */
+   ProgramLine *target;         /* The linked jump target, or NULL     */
+   int targetNumber;            /* The linked jump line number, or -1  */
+};
+
 /*
  * This class stores the lines in a BASIC program.  Each line
  * in the program is stored in order according to its line number.
@@ -24,6 +51,10 @@ using namespace std;
  *
  * 2. The parsed representation of that statement, which is a
  *    pointer to a Statement.
+ *
+ * The lines are also kept linked to each other, as described for
+ * ProgramLine, so that a running program moves from line to line
+ * and follows its jumps without searching for line numbers.
  */
 
 class Program {
@@ -52,11 +83,60 @@ public:
  * Method: clear
  * Usage: program.clear();
  * -----------------------
- * Removes all lines from the program.
+ * Removes all lines from the program and forgets its origin.
  */
 
    void clear();
 
+/*
+ * Method: swap
+ * Usage: program.swap(other);
+ * ---------------------------
+ * Exchanges the contents of this program with those of other in
+ * constant time.  Loaders build a complete program on the side and
+ * swap it in, so that an error partway through leaves the current
+ * program as it was.  Pointers to lines stay valid and move with them.
+ */
+
+   void swap(Program & other);
+
+/*
+ * Method: checkRoomFor
+ * Usage: program.checkRoomFor(lineCount, textBytes);
+ * --------------------------------------------------
+ * Calls error with the message "OUT OF MEMORY", changing nothing, if
+ * adding lineCount lines holding textBytes bytes of text in all could
+ * take the session over its memory limit.  A caller that checks first
+ * can then add those lines knowing that none of them will fail.
+ */
+
+   void checkRoomFor(size_t lineCount, size_t textBytes);
+
+/*
+ * Method: setOrigin
+ * Usage: program.setOrigin(filename, fileHash, textHash);
+ * -------------------------------------------------------
+ * Records that the program was loaded from the named source file, whose
+ * contents hashed to fileHash, at a moment when its own text hashed to
+ * textHash.  SAVE COMPILED uses this to tie an image to its source
+ * file.  Calling setOrigin with an empty filename forgets the origin.
+ */
+
+   void setOrigin(const std::string & filename, unsigned long long fileHash,
+                  unsigned long long textHash);
+
+/*
+ * Methods: getOriginFile, getOriginFileHash, getOriginTextHash
+ * Usage: string filename = program.getOriginFile();
+ * -------------------------------------------------
+ * Return the values recorded by setOrigin.  The filename is empty if
+ * the program was not loaded from a file.
+ */
+
+   std::string getOriginFile();
+   unsigned long long getOriginFileHash();
+   unsigned long long getOriginTextHash();
+
 /*
  * Method: addSourceLine
  * Usage: program.addSourceLine(lineNumber, line);
@@ -92,6 +172,16 @@ public:
 
    std::string getSourceLine(int lineNumber);
 
+/*
+ * Method: listSource
+ * Usage: program.listSource(cout);
+ * --------------------------------
+ * Writes every source line to the stream in line-number order, each
+ * followed by a newline, and then flushes the stream once.
+ */
+
+   void listSource(std::ostream & os);
+
 /*
  * Method: setParsedStatement
  * Usage: program.setParsedStatement(lineNumber, stmt);
@@ -136,9 +226,87 @@ public:
 
    int getNextLineNumber(int lineNumber);
 
+/*
+ * Method: link
+ * Usage: program.link();
+ * ----------------------
+ * Resolves the jump target of every line whose statement has changed
+ * since the last call.  Lines that jump to a line that is added or
+ * removed are patched when the edit happens, so the cost of link is
+ * proportional to the number of edited lines rather than to the size
+ * of the program.  link also rebuilds the line-number index if edits
+ * have outgrown it.  RUN calls link before it starts executing.
+ */
+
+   void link();
+
+/*
+ * Method: getFirstLine
+ * Usage: ProgramLine *line = program.getFirstLine();
+ * --------------------------------------------------
+ * Returns the first line of the program, or NULL if the program is
+ * empty.  The remaining lines are reached through the next field.
+ * The pointers stay valid until the lines they refer to are removed.
+ */
+
+   ProgramLine *getFirstLine();
+
+/*
+ * Method: getLine
+ * Usage: ProgramLine *line = program.getLine(lineNumber);
+ * -------------------------------------------------------
+ * Returns the line with the specified number, or NULL if there is no
+ * such line.  After link this takes constant time.
+ */
+
+   ProgramLine *getLine(int lineNumber);
+
+/*
+ * Method: renumber
+ * Usage: program.renumber(start, step);
+ * -------------------------------------
+ * Gives the lines the numbers start, start + step, start + 2 * step and
+ * so on, in their current order.  Every GOTO and IF_THEN statement that
+ * jumps to an existing line is changed to jump to that line's new
+ * number, and the line number and jump target in the source text of
+ * each line are rewritten to match.  If start is negative, step is not
+ * positive, the last number would not fit in an int, or some GOTO or
+ * IF_THEN statement jumps to a line that does not exist, this method
+ * calls error and leaves the program unchanged.
+ */
+
+   void renumber(int start, int step);
+
 private:
-	map<int, string> Sourceline;
-	map<int, Statement*> ParsedStatement;
+	map<int, ProgramLine> lines;         /* The lines, by line number       */
+	set<int> dirtyLines;                 /* Lines that need to be relinked  */
+	map<int, set<int> > referrers;       /* Jump target -> jumping lines    */
+	string sourcePool;                   /* The text of every line          */
+	size_t deadText;                     /* Pool bytes no line refers to    */
+	bool poolInOrder;                    /* True if the pool holds exactly  */
+	                                     /* the lines, in line order        */
+
+	/* The line-number index used by findLine */
+
+	bool indexValid;                     /* False until the next link       */
+	bool indexDense;                     /* Direct array or hash table      */
+	int indexBase;                       /* Line number of denseIndex[0]    */
+	size_t indexBytes;                   /* Memory charged for the index    */
+	vector<ProgramLine *> denseIndex;    /* Lines by number - indexBase     */
+	unordered_map<int, ProgramLine *> sparseIndex;
+
+	/* The source file recorded by setOrigin */
+
+	string originFile;                   /* Empty if none                   */
+	unsigned long long originFileHash;   /* Hash of the file's bytes        */
+	unsigned long long originTextHash;   /* Hash of the program text then   */
+
+	void unlinkJump(ProgramLine & line);
+	ProgramLine *findLine(int lineNumber);
+	void indexLine(int lineNumber, ProgramLine *line);
+	void rebuildIndex();
+	void storeSource(ProgramLine & line, const string & text);
+	void compactSource();
 
 };
 
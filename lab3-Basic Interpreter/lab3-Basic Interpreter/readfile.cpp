@@ -0,0 +1,34 @@
+/*
+ * File: readfile.cpp
+ * ------------------
+ * This file implements the readWholeFile function.
+ */
+
+#include <iostream>
+#include <string>
+#include "readfile.h"
+using namespace std;
+
+static const int CHUNK_SIZE = 64 * 1024;
+
+/*
+ * Implementation notes: readWholeFile
+ * -----------------------------------
+ * The stream is read in fixed-size chunks until a read comes up short.
+ * Asking the stream for its length would be quicker for a regular file,
+ * but tellg returns -1 on a pipe, so the length is never relied on.
+ * The string grows geometrically, so the copying stays linear.
+ */
+
+bool readWholeFile(istream & is, string & contents) {
+   contents.clear();
+   size_t length = 0;
+   while (true) {
+      contents.resize(length + CHUNK_SIZE);
+      is.read(&contents[length], CHUNK_SIZE);
+      length += size_t(is.gcount());
+      if (!is) break;
+   }
+   contents.resize(length);
+   return is.eof() && !is.bad();
+}
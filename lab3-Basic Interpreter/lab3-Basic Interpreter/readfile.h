@@ -0,0 +1,27 @@
+/*
+ * File: readfile.h
+ * ----------------
+ * This interface exports readWholeFile, which reads the rest of a stream
+ * into a string for the commands that load a file and then decode it
+ * from memory.
+ */
+
+#ifndef _readfile_h
+#define _readfile_h
+
+#include <iostream>
+#include <string>
+
+/*
+ * Function: readWholeFile
+ * Usage: if (!readWholeFile(infile, contents)) ...
+ * ------------------------------------------------
+ * Reads everything left in the stream into contents, replacing what it
+ * held, and returns true if the stream was read to its end without an
+ * error.  The stream need not be seekable, so a pipe or FIFO can be
+ * read as well as a regular file.
+ */
+
+bool readWholeFile(std::istream & is, std::string & contents);
+
+#endif
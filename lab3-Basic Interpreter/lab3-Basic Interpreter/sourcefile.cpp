@@ -0,0 +1,166 @@
+/*
+ * File: sourcefile.cpp
+ * --------------------
+ * This file implements the sourcefile.h interface.
+ */
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "compiled.h"
+#include "readfile.h"
+#include "sourcefile.h"
+#include "statement.h"
+
+#include "../StanfordCPPLib/error.h"
+#include "../StanfordCPPLib/strlib.h"
+#include "../StanfordCPPLib/tokenscanner.h"
+using namespace std;
+
+/*
+ * Type: SourceEntry
+ * -----------------
+ * One parsed line of a source file.  A NULL statement means the line
+ * held only its number and removes that line from the program.  The
+ * entry owns its statement until the program takes it.
+ */
+
+struct SourceEntry {
+   int lineNumber;
+   string source;
+   unique_ptr<Statement> stmt;
+};
+
+/*
+ * Implementation notes: readSourceText, parseSourceText
+ * -----------------------------------------------------
+ * The file is read into memory with a single bulk read and split into
+ * lines in place; a trailing carriage return is dropped so that files
+ * written on Windows load unchanged.  Every line is parsed with the
+ * session's ParseContext before anything is added to the program, so
+ * that a bad line leaves the program as it was.
+ */
+
+static void readSourceText(const string & command, const string & filename,
+                           string & text) {
+   ifstream infile(filename.c_str(), ios::binary);
+   if (infile.fail()) error(command + ": can't open " + filename);
+   if (!readWholeFile(infile, text)) {
+      error(command + ": can't read " + filename);
+   }
+}
+
+static void parseSourceText(const string & command, const string & filename,
+                            const string & text, ParseContext & context,
+                            vector<SourceEntry> & entries) {
+   size_t start = 0;
+   int fileLine = 0;
+   while (start < text.length()) {
+      size_t end = text.find('\n', start);
+      if (end == string::npos) end = text.length();
+      fileLine++;
+      size_t stop = end;
+      if (stop > start && text[stop - 1] == '\r') stop--;
+      string line = text.substr(start, stop - start);
+      start = end + 1;
+      TokenScanner & scanner = context.reset(line);
+      string token = scanner.nextToken();
+      if (token == "") continue;
+      SourceEntry entry;
+      if (scanner.getTokenType(token) != NUMBER
+          || !tryStringToInteger(token, entry.lineNumber)) {
+         error(command + ": " + filename + " line "
+               + integerToString(fileLine) + ": missing line number");
+      }
+      if (scanner.hasMoreTokens()) {
+         try {
+            entry.stmt.reset(parseState(scanner));
+         } catch (ErrorException & ex) {
+            error(command + ": " + filename + " line "
+                  + integerToString(fileLine) + ": " + ex.getMessage());
+         }
+         if (entry.stmt == NULL) {
+            error(command + ": " + filename + " line "
+                  + integerToString(fileLine) + ": illegal statement");
+         }
+         entry.source.swap(line);
+      }
+      entries.push_back(std::move(entry));
+   }
+}
+
+/*
+ * Implementation notes: addEntries, loadSourceFile, mergeSourceFile
+ * -----------------------------------------------------------------
+ * The only error that adding a parsed line can raise is OUT OF MEMORY.
+ * LOAD adds the lines to a separate program and swaps it in once all
+ * of them are there, so a failure leaves the current program intact.
+ * MERGE cannot work on the side without copying the whole program, so
+ * it first checks that the lines fit within the memory limit, after
+ * which none of them can fail.  Each statement stays owned by its entry
+ * until the program has the line that takes it, so whatever is not
+ * added is freed with the entries.
+ *
+ * Before parsing anything, LOAD tries the cache image kept next to the
+ * file, which loadCachedProgram accepts only if it was made from these
+ * exact contents.  Otherwise the file is parsed and the result is cached
+ * for the next LOAD of the same file.
+ */
+
+static void addEntries(Program & program, vector<SourceEntry> & entries) {
+   for (size_t i = 0; i < entries.size(); i++) {
+      SourceEntry & entry = entries[i];
+      if (entry.stmt == NULL) {
+         program.removeSourceLine(entry.lineNumber);
+      } else {
+         program.addSourceLine(entry.lineNumber, entry.source);
+         program.setParsedStatement(entry.lineNumber, entry.stmt.get());
+         entry.stmt.release();
+      }
+   }
+}
+
+void loadSourceFile(Program & program, const string & filename,
+                    ParseContext & context) {
+   string text;
+   readSourceText("LOAD", filename, text);
+   unsigned long long fileHash = hashFileContents(text);
+   if (loadCachedProgram(program, filename, fileHash)) return;
+   vector<SourceEntry> entries;
+   parseSourceText("LOAD", filename, text, context, entries);
+   Program loaded;
+   addEntries(loaded, entries);
+   loaded.setOrigin(filename, fileHash, hashProgramSource(loaded));
+   program.swap(loaded);
+   cacheCompiledProgram(program);
+}
+
+void mergeSourceFile(Program & program, const string & filename,
+                     ParseContext & context) {
+   string text;
+   readSourceText("MERGE", filename, text);
+   vector<SourceEntry> entries;
+   parseSourceText("MERGE", filename, text, context, entries);
+   size_t textBytes = 0;
+   for (size_t i = 0; i < entries.size(); i++) {
+      textBytes += entries[i].source.length();
+   }
+   program.checkRoomFor(entries.size(), textBytes);
+   addEntries(program, entries);
+}
+
+/*
+ * Implementation notes: saveSourceFile
+ * ------------------------------------
+ * Program::listSource writes the whole source pool in one call, so the
+ * file is written without any per-line work.
+ */
+
+void saveSourceFile(Program & program, const string & filename) {
+   ofstream out(filename.c_str(), ios::binary | ios::trunc);
+   if (out.fail()) error("SAVE: can't open " + filename);
+   program.listSource(out);
+   out.close();
+   if (out.fail()) error("SAVE: can't write " + filename);
+}
@@ -0,0 +1,55 @@
+/*
+ * File: sourcefile.h
+ * ------------------
+ * This interface exports functions that read a BASIC program from a
+ * text file and write it back.  A source file holds one numbered line
+ * per line of text, exactly as it would be typed at the prompt.
+ */
+
+#ifndef _sourcefile_h
+#define _sourcefile_h
+
+#include <string>
+#include "parser.h"
+#include "program.h"
+
+/*
+ * Function: loadSourceFile
+ * Usage: loadSourceFile(program, filename, context);
+ * --------------------------------------------------
+ * Replaces the contents of program with the lines in the named file.
+ * A line holding only a line number removes any earlier line with that
+ * number, and blank lines are ignored.  If the file cannot be read or
+ * any line fails to parse, this function calls error, naming the file
+ * line at fault, and leaves program unchanged.  The parsed program is
+ * cached in an image next to the file, as described in compiled.h, and
+ * a later LOAD of the same unchanged file reads that image instead of
+ * parsing the file again.
+ */
+
+void loadSourceFile(Program & program, const std::string & filename,
+                    ParseContext & context);
+
+/*
+ * Function: mergeSourceFile
+ * Usage: mergeSourceFile(program, filename, context);
+ * ---------------------------------------------------
+ * Adds the lines in the named file to program, replacing lines with the
+ * same numbers, as if each had been typed at the prompt.  Errors are
+ * handled as in loadSourceFile, and leave program unchanged.
+ */
+
+void mergeSourceFile(Program & program, const std::string & filename,
+                     ParseContext & context);
+
+/*
+ * Function: saveSourceFile
+ * Usage: saveSourceFile(program, filename);
+ * -----------------------------------------
+ * Writes the source lines of program to the named file in line-number
+ * order.  If the file cannot be written, this function calls error.
+ */
+
+void saveSourceFile(Program & program, const std::string & filename);
+
+#endif
@@ -8,7 +8,11 @@
  */
 
 #include <string>
+#include "memusage.h"
 #include "statement.h"
+
+#include "../StanfordCPPLib/error.h"
+#include "../StanfordCPPLib/strlib.h"
 using namespace std;
 
 /* Implementation of the Statement class */
@@ -21,6 +25,17 @@ Statement::~Statement() {
    /* Empty */
 }
 
+void *Statement::operator new(size_t size) {
+   chargeMemory(MEM_STATEMENTS, size);
+   return ::operator new(size);
+}
+
+void Statement::operator delete(void *ptr, size_t size) {
+   if (ptr == NULL) return;
+   releaseMemory(MEM_STATEMENTS, size);
+   ::operator delete(ptr);
+}
+
 /* Implementation of the REMSTATE class */
 
 REMSTATE::REMSTATE()
@@ -32,13 +47,19 @@ void REMSTATE::execute(EvalState & state)
 {
 	/* Empty */
 }
+
+StatementType REMSTATE::getType()
+{
+	return REM;
+}
 
 /*
 * Implementation notes: the LETState subclass
 * ------------------------------------------------
 * The LETState subclass assigned value to a single instance variable 
 * and it will check the name of variable to make sure them are not
-* conflict to the reserved name.
+* conflict to the reserved name.  The name is interned once here, so
+* execute assigns the variable by atom.
 */
 
 LETState::LETState(std::string var, Expression * exp)
@@ -49,7 +70,7 @@ LETState::LETState(std::string var, Expression * exp)
 		error("variable conflict to the reserved name");
 	}
 	this->exp = exp;
-	this->var = var;
+	this->var = internAtom(var);
 }
 
 LETState::~LETState()
@@ -61,6 +82,21 @@ void LETState::execute(EvalState & state)
 {
 	state.setValue(var, exp->eval(state));
 }
+
+StatementType LETState::getType()
+{
+	return LET;
+}
+
+string LETState::getVar()
+{
+	return getAtomName(var);
+}
+
+Expression *LETState::getExp()
+{
+	return exp;
+}
 
 /* Implementation of the PRINTState class */
 
@@ -76,7 +112,21 @@ PRINTState::~PRINTState()
 
 void PRINTState::execute(EvalState & state)
 {
-	cout << exp->eval(state) << endl;
+	int value = exp->eval(state);
+	cout << value << endl;
+	ExecutionTrace *trace = state.getTrace();
+	if (trace != NULL)
+		trace->recordOutput(value);
+}
+
+StatementType PRINTState::getType()
+{
+	return PRINT;
+}
+
+Expression *PRINTState::getExp()
+{
+	return exp;
 }
 
 /*
@@ -84,30 +134,48 @@ void PRINTState::execute(EvalState & state)
 * ------------------------------------------------
 * The INPUTState subclass ask user to input a value to variable 
 * which must be an integer, if not, repeat output prompt " ? ". 
+* The line is checked and converted in one pass by tryStringToInteger,
+* which also rejects values that overflow an int.  When the state has an
+* active InputFeed, the value is taken from it instead, with no prompt.
+* Every value assigned is also reported to the state's trace, if any.
 */
 
 INPUTState::INPUTState(std::string var)
 {
-	this->var = var;
+	this->var = internAtom(var);
 }
 
 void INPUTState::execute(EvalState & state)
 {
-	string value;
-	const string digit = "0123456789-";
-	while (true) {
-		cout << " ? ";
-		getline(cin, value);
-		bool flag = 1;
-		for (auto it = value.begin(); it != value.end(); it++)
-			if (digit.find(*it) == string::npos) {
-				cout << "INVALID NUMBER" << endl;
-				flag = 0;
-				break;
-			}
-		if (flag)	break;
+	InputFeed *feed = state.getInputFeed();
+	string line;
+	int value;
+	if (feed != NULL && feed->isActive()) {
+		value = feed->nextValue();
+	} else {
+		while (true) {
+			cout << " ? ";
+			if (!getline(cin, line))
+				error("INPUT: no more input");
+			if (tryStringToInteger(line, value))
+				break;
+			cout << "INVALID NUMBER" << endl;
+		}
 	}
-	state.setValue(var, stoi(value));
+	state.setValue(var, value);
+	ExecutionTrace *trace = state.getTrace();
+	if (trace != NULL)
+		trace->recordInput(value);
+}
+
+StatementType INPUTState::getType()
+{
+	return INPUT;
+}
+
+string INPUTState::getVar()
+{
+	return getAtomName(var);
 }
 
 /* Implementation of the ENDState class */
@@ -120,6 +188,11 @@ void ENDState::execute(EvalState & state)
 {
 	error("end");
 }
+
+StatementType ENDState::getType()
+{
+	return END;
+}
 
 /* Implementation of the GOTOState class */
 
@@ -130,7 +203,22 @@ GOTOState::GOTOState(int lineNumber)
 
 void GOTOState::execute(EvalState & state)
 {
-	state.setValue("GOTO", lineNumber);
+	state.setJump(lineNumber);
+}
+
+StatementType GOTOState::getType()
+{
+	return GOTO;
+}
+
+int GOTOState::getLineNumber()
+{
+	return lineNumber;
+}
+
+void GOTOState::setLineNumber(int lineNumber)
+{
+	this->lineNumber = lineNumber;
 }
 
 /*
@@ -150,14 +238,47 @@ IFTHENState::IFTHENState(Expression * lhs, char cmp, Expression * rhs, int lineN
 
 IFTHENState::~IFTHENState()
 {
-	delete lhs, rhs;
+	delete lhs;
+	delete rhs;
 }
 
 void IFTHENState::execute(EvalState & state)
 {
-	if ((cmp == '='&&lhs->eval(state) == rhs->eval(state))
-		|| (cmp == '>'&&lhs->eval(state) > rhs->eval(state))
-		|| (cmp == '<'&&lhs->eval(state) < rhs->eval(state)))
-		state.setValue("THEN", lineNumber);
+	int left = lhs->eval(state);
+	int right = rhs->eval(state);
+	if ((cmp == '=' && left == right)
+		|| (cmp == '>' && left > right)
+		|| (cmp == '<' && left < right))
+		state.setJump(lineNumber);
+}
+
+StatementType IFTHENState::getType()
+{
+	return IFTHEN;
+}
+
+Expression *IFTHENState::getLHS()
+{
+	return lhs;
+}
+
+char IFTHENState::getCmp()
+{
+	return cmp;
+}
+
+Expression *IFTHENState::getRHS()
+{
+	return rhs;
+}
+
+int IFTHENState::getLineNumber()
+{
+	return lineNumber;
+}
+
+void IFTHENState::setLineNumber(int lineNumber)
+{
+	this->lineNumber = lineNumber;
 }
 
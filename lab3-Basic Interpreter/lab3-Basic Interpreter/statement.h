@@ -63,6 +63,29 @@ public:
 
    virtual void execute(EvalState & state) = 0;
 
+/*
+ * Method: getType
+ * Usage: StatementType type = stmt->getType();
+ * --------------------------------------------
+ * Returns the type of the statement, which must be one of the constants
+ * REM, LET, PRINT, INPUT, END, GOTO or IFTHEN.
+ */
+
+   virtual StatementType getType() = 0;
+
+/*
+ * Operators: new, delete
+ * Usage: Statement *stmt = new PRINTState(exp);
+ *        delete stmt;
+ * ---------------------------------------------
+ * Statements are allocated from the heap as usual, but their size is
+ * charged to the session's memory account, so creating a statement can
+ * report OUT OF MEMORY.
+ */
+
+   static void *operator new(std::size_t size);
+   static void operator delete(void *ptr, std::size_t size);
+
 };
 
 /*
@@ -103,6 +126,7 @@ public:
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
 private:
 };
 
@@ -143,9 +167,21 @@ public:
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
+
+/*
+ * Methods: getVar, getExp
+ * Usage: string var = ((LETState *) stmt)->getVar();
+ *        Expression *exp = ((LETState *) stmt)->getExp();
+ * -------------------------------------------------------
+ * These methods return the components of a LET statement.
+ */
+
+	std::string getVar();
+	Expression *getExp();
 
 private:
-	string var;
+	Atom var;
 	Expression* exp;
 };
 
@@ -186,6 +222,16 @@ public:
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
+
+/*
+ * Method: getExp
+ * Usage: Expression *exp = ((PRINTState *) stmt)->getExp();
+ * ---------------------------------------------------------
+ * Returns the expression printed by this statement.
+ */
+
+	Expression *getExp();
 
 private:
 	Expression* exp;
@@ -216,13 +262,24 @@ public:
  * ----------------------------
  * This method executes a INPUT statement.It ask user to input a value
  * to variable which must be an integer, if not, repeat output 
- * prompt " ? ".
+ * prompt " ? ".  If the state has an active InputFeed, the value is
+ * taken from the feed instead.
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
+
+/*
+ * Method: getVar
+ * Usage: string var = ((INPUTState *) stmt)->getVar();
+ * ----------------------------------------------------
+ * Returns the name of the variable read by this statement.
+ */
+
+	std::string getVar();
 
 private:
-	string var;
+	Atom var;
 };
 
 /*
@@ -251,6 +308,7 @@ public:
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
 private:
 };
 
@@ -276,10 +334,30 @@ public:
  * Method: execute
  * Usage: stmt->execute(state);
  * ----------------------------
- * This method executes a GOTO statement.It skip the program to the goal line.
+ * This method executes a GOTO statement.It skip the program to the goal line
+ * by recording a jump with state.setJump.
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
+
+/*
+ * Method: getLineNumber
+ * Usage: int target = ((GOTOState *) stmt)->getLineNumber();
+ * ----------------------------------------------------------
+ * Returns the line number this statement jumps to.
+ */
+
+	int getLineNumber();
+
+/*
+ * Method: setLineNumber
+ * Usage: ((GOTOState *) stmt)->setLineNumber(target);
+ * ---------------------------------------------------
+ * Changes the line number this statement jumps to.  RENUM uses this.
+ */
+
+	void setLineNumber(int lineNumber);
 
 private:
 	int lineNumber;
@@ -299,8 +377,7 @@ public:
  * Usage: IFTHENState *stmt = new IFTHENState(lhs,cmp,rhs,lineNumber);
  * ------------------------------------------------
  * The constructor initializes a new IF_THEN statement with condition
- * of lhs cmp rhs and goal lineNumber give the result by create a variable
- * named "THEN" in Evalstate.
+ * of lhs cmp rhs and goal lineNumber.
  */
 
 	IFTHENState(Expression *lhs,char cmp, Expression *rhs, int lineNumber);
@@ -319,11 +396,36 @@ public:
  * Usage: stmt->execute(state);
  * ----------------------------
  * This method executes a IF_THEN statement.It judge the condition whether
- * true or false and give the result by create a variable named "THEN"
- * in Evalstate.
+ * true or false and, if it is true, records a jump to the goal line
+ * with state.setJump.
  */
 
 	virtual void execute(EvalState & state);
+	virtual StatementType getType();
+
+/*
+ * Methods: getLHS, getCmp, getRHS, getLineNumber
+ * Usage: Expression *lhs = ((IFTHENState *) stmt)->getLHS();
+ *        char cmp = ((IFTHENState *) stmt)->getCmp();
+ *        Expression *rhs = ((IFTHENState *) stmt)->getRHS();
+ *        int target = ((IFTHENState *) stmt)->getLineNumber();
+ * ----------------------------------------------------------
+ * These methods return the components of an IF_THEN statement.
+ */
+
+	Expression *getLHS();
+	char getCmp();
+	Expression *getRHS();
+	int getLineNumber();
+
+/*
+ * Method: setLineNumber
+ * Usage: ((IFTHENState *) stmt)->setLineNumber(target);
+ * -----------------------------------------------------
+ * Changes the line number this statement jumps to.  RENUM uses this.
+ */
+
+	void setLineNumber(int lineNumber);
 
 private:
 	Expression * lhs, *rhs;
@@ -0,0 +1,132 @@
+/*
+ * File: symbolbench.cpp
+ * ---------------------
+ * This program times the SymbolTable that maps variable names to atoms
+ * against the StanfordCPPLib Map, the two lookups the atom table can be
+ * built with (see ATOM_TABLE_USE_MAP in atom.h).  It is not part of the
+ * interpreter and is left out of the project; build it on its own with
+ *
+ *    g++ -O2 -std=c++17 symbolbench.cpp symboltable.cpp \
+ *        ../StanfordCPPLib/libStanfordCPPLib.a
+ *
+ * Each round puts every name and then looks each one up with
+ * containsKey and get, the calls internAtom and findAtom make when they
+ * add a new name and when they find an existing one.  Both tables are
+ * first checked to agree on a randomized mix of operations.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "symboltable.h"
+
+#include "../StanfordCPPLib/map.h"
+using namespace std;
+
+static const int NUM_NAMES = 2000;
+static const int NUM_ROUNDS = 500;
+
+/*
+ * Function: makeNames
+ * Usage: vector<string> names = makeNames(count);
+ * -----------------------------------------------
+ * Returns count distinct variable names of 1 to 10 characters, most of
+ * them short enough to stay inside a string's inline buffer.
+ */
+
+static vector<string> makeNames(int count) {
+   mt19937 rng(42);
+   const string chars = "abcdefghijklmnopqrstuvwxyz0123456789";
+   Map<string,int> seen;
+   vector<string> names;
+   while ((int) names.size() < count) {
+      string name(1, chars[rng() % 26]);
+      int length = 1 + rng() % 10;
+      while ((int) name.length() < length) {
+         name += chars[rng() % chars.length()];
+      }
+      if (!seen.containsKey(name)) {
+         seen.put(name, 0);
+         names.push_back(name);
+      }
+   }
+   return names;
+}
+
+/*
+ * Function: checkAgreement
+ * Usage: checkAgreement(names);
+ * -----------------------------
+ * Applies the same random puts, removes and lookups to both tables and
+ * exits with an error message if they ever disagree.
+ */
+
+static void checkAgreement(const vector<string> & names) {
+   mt19937 rng(7);
+   SymbolTable table;
+   Map<string,int> map;
+   for (int i = 0; i < 200000; i++) {
+      const string & name = names[rng() % names.size()];
+      int op = rng() % 3;
+      if (op == 0) {
+         table.put(name, i);
+         map.put(name, i);
+      } else if (op == 1) {
+         table.remove(name);
+         map.remove(name);
+      }
+      bool found = table.containsKey(name);
+      if (found != map.containsKey(name)
+          || (found && table.get(name) != map.get(name))
+          || table.size() != map.size()) {
+         cerr << "SymbolTable and Map disagree on " << name << endl;
+         exit(1);
+      }
+   }
+}
+
+/*
+ * Function: timeTable
+ * Usage: double ms = timeTable(table, names, sink);
+ * -------------------------------------------------
+ * Runs NUM_ROUNDS rounds over names on a table with the put, containsKey
+ * and get methods both backends share, and returns the time taken in
+ * milliseconds.  The values read are summed into sink so that the
+ * compiler cannot drop the lookups.
+ */
+
+template <typename TableType>
+static double timeTable(TableType & table, const vector<string> & names,
+                        long long & sink) {
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int round = 0; round < NUM_ROUNDS; round++) {
+      for (size_t i = 0; i < names.size(); i++) {
+         table.put(names[i], round + int(i));
+      }
+      for (size_t i = 0; i < names.size(); i++) {
+         if (table.containsKey(names[i])) sink += table.get(names[i]);
+      }
+   }
+   chrono::duration<double, milli> elapsed =
+      chrono::steady_clock::now() - start;
+   return elapsed.count();
+}
+
+int main() {
+   vector<string> names = makeNames(NUM_NAMES);
+   checkAgreement(names);
+   long long sink = 0;
+   SymbolTable table;
+   Map<string,int> map;
+   double tableTime = timeTable(table, names, sink);
+   double mapTime = timeTable(map, names, sink);
+   cout << NUM_NAMES << " names, " << NUM_ROUNDS
+        << " rounds of put, containsKey and get" << endl;
+   cout << "SymbolTable " << tableTime << " ms" << endl;
+   cout << "Map         " << mapTime << " ms" << endl;
+   cout << "(checksum " << sink << ")" << endl;
+   return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * File: symboltable.cpp
+ * ---------------------
+ * This file implements the SymbolTable class.
+ */
+
+#include <string>
+#include <string_view>
+#include "symboltable.h"
+using namespace std;
+
+static const int INITIAL_CAPACITY = 16;
+
+SymbolTable::SymbolTable() {
+   capacity = INITIAL_CAPACITY;
+   count = 0;
+   slots = new Slot[capacity];
+   for (int i = 0; i < capacity; i++) {
+      slots[i].used = false;
+   }
+}
+
+SymbolTable::~SymbolTable() {
+   delete[] slots;
+}
+
+/*
+ * Implementation notes: hashKey
+ * -----------------------------
+ * Keys are hashed with 64-bit FNV-1a.  The low bits select the home
+ * slot and the whole value is kept in the slot for quick rejection.
+ */
+
+unsigned long long SymbolTable::hashKey(string_view key) {
+   unsigned long long hash = 14695981039346656037ULL;
+   for (size_t i = 0; i < key.length(); i++) {
+      hash ^= (unsigned char) key[i];
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+/*
+ * Implementation notes: findSlot
+ * ------------------------------
+ * Probes linearly from the key's home slot.  Returns the index of the
+ * slot holding the key or, if the key is absent, the index of the empty
+ * slot that ends the probe sequence.  The table is never full, so the
+ * loop always terminates.
+ */
+
+int SymbolTable::findSlot(string_view key, unsigned long long hash) const {
+   int mask = capacity - 1;
+   int index = int(hash & mask);
+   while (slots[index].used) {
+      if (slots[index].hash == hash && slots[index].key == key) break;
+      index = (index + 1) & mask;
+   }
+   return index;
+}
+
+void SymbolTable::put(string_view key, int value) {
+   unsigned long long hash = hashKey(key);
+   int index = findSlot(key, hash);
+   if (slots[index].used) {
+      slots[index].value = value;
+      return;
+   }
+   if (4 * (count + 1) > 3 * capacity) {
+      expand();
+      index = findSlot(key, hash);
+   }
+   Slot & slot = slots[index];
+   slot.key.assign(key.data(), key.length());
+   slot.hash = hash;
+   slot.value = value;
+   slot.used = true;
+   count++;
+}
+
+int SymbolTable::get(string_view key) const {
+   const int *vp = lookup(key);
+   return (vp == NULL) ? 0 : *vp;
+}
+
+const int *SymbolTable::lookup(string_view key) const {
+   int index = findSlot(key, hashKey(key));
+   return slots[index].used ? &slots[index].value : NULL;
+}
+
+bool SymbolTable::containsKey(string_view key) const {
+   return lookup(key) != NULL;
+}
+
+/*
+ * Implementation notes: remove
+ * ----------------------------
+ * Removal uses backward-shift deletion instead of tombstones.  After the
+ * slot is emptied, each following entry in the same cluster whose home
+ * slot does not lie strictly between the hole and its own position is
+ * moved back into the hole, which keeps every probe sequence unbroken.
+ */
+
+void SymbolTable::remove(string_view key) {
+   int hole = findSlot(key, hashKey(key));
+   if (!slots[hole].used) return;
+   int mask = capacity - 1;
+   int next = hole;
+   while (true) {
+      next = (next + 1) & mask;
+      if (!slots[next].used) break;
+      int home = int(slots[next].hash & mask);
+      bool between = (hole <= next) ? (hole < home && home <= next)
+                                    : (hole < home || home <= next);
+      if (!between) {
+         slots[hole].key.swap(slots[next].key);
+         slots[hole].hash = slots[next].hash;
+         slots[hole].value = slots[next].value;
+         hole = next;
+      }
+   }
+   slots[hole].used = false;
+   slots[hole].key.clear();
+   count--;
+}
+
+void SymbolTable::clear() {
+   for (int i = 0; i < capacity; i++) {
+      slots[i].used = false;
+      slots[i].key.clear();
+   }
+   count = 0;
+}
+
+int SymbolTable::size() const {
+   return count;
+}
+
+/*
+ * Implementation notes: expand
+ * ----------------------------
+ * Doubles the capacity and moves every entry to its slot in the new
+ * array using the stored hash.  Keys are swapped rather than copied.
+ */
+
+void SymbolTable::expand() {
+   Slot *oldSlots = slots;
+   int oldCapacity = capacity;
+   capacity *= 2;
+   slots = new Slot[capacity];
+   for (int i = 0; i < capacity; i++) {
+      slots[i].used = false;
+   }
+   int mask = capacity - 1;
+   for (int i = 0; i < oldCapacity; i++) {
+      if (!oldSlots[i].used) continue;
+      int index = int(oldSlots[i].hash & mask);
+      while (slots[index].used) {
+         index = (index + 1) & mask;
+      }
+      slots[index].key.swap(oldSlots[i].key);
+      slots[index].hash = oldSlots[i].hash;
+      slots[index].value = oldSlots[i].value;
+      slots[index].used = true;
+   }
+   delete[] oldSlots;
+}
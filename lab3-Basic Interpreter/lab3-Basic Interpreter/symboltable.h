@@ -0,0 +1,141 @@
+/*
+ * File: symboltable.h
+ * -------------------
+ * This interface exports the SymbolTable class, a hash table from
+ * strings to integers that the atom table uses to find the atom for a
+ * variable name.
+ */
+
+#ifndef _symboltable_h
+#define _symboltable_h
+
+#include <string>
+#include <string_view>
+
+/*
+ * Class: SymbolTable
+ * ------------------
+ * This class maps strings to ints using open addressing with linear
+ * probing.  Each slot stores the full hash of its key next to the key
+ * and value, so a probe compares hashes before it compares strings and
+ * growing the table never rehashes a key.  The keys are std::strings,
+ * whose small-string buffer keeps short variable names inline in the
+ * slot.  All lookups take a std::string_view, so callers holding a
+ * string, a string literal or a slice of a line need not build a
+ * temporary std::string.
+ */
+
+class SymbolTable {
+
+public:
+
+/*
+ * Constructor: SymbolTable
+ * Usage: SymbolTable table;
+ * -------------------------
+ * Creates an empty table.
+ */
+
+   SymbolTable();
+
+/*
+ * Destructor: ~SymbolTable
+ * Usage: usually implicit
+ * -----------------------
+ * Frees all heap storage associated with this table.
+ */
+
+   ~SymbolTable();
+
+/*
+ * Method: put
+ * Usage: table.put(key, value);
+ * -----------------------------
+ * Associates key with value, replacing any previous value.
+ */
+
+   void put(std::string_view key, int value);
+
+/*
+ * Method: get
+ * Usage: int value = table.get(key);
+ * ----------------------------------
+ * Returns the value associated with key, or 0 if there is none.
+ */
+
+   int get(std::string_view key) const;
+
+/*
+ * Method: lookup
+ * Usage: const int *vp = table.lookup(key);
+ * -----------------------------------------
+ * Returns a pointer to the value associated with key, or NULL if key
+ * is not in the table.  The pointer is invalidated by the next put or
+ * remove.
+ */
+
+   const int *lookup(std::string_view key) const;
+
+/*
+ * Method: containsKey
+ * Usage: if (table.containsKey(key)) ...
+ * --------------------------------------
+ * Returns true if key is in the table.
+ */
+
+   bool containsKey(std::string_view key) const;
+
+/*
+ * Method: remove
+ * Usage: table.remove(key);
+ * -------------------------
+ * Removes key and its value from the table, if it is present.
+ */
+
+   void remove(std::string_view key);
+
+/*
+ * Method: clear
+ * Usage: table.clear();
+ * ---------------------
+ * Removes all entries from the table.
+ */
+
+   void clear();
+
+/*
+ * Method: size
+ * Usage: int n = table.size();
+ * ----------------------------
+ * Returns the number of entries in the table.
+ */
+
+   int size() const;
+
+/* Private section */
+
+private:
+
+   struct Slot {
+      std::string key;
+      unsigned long long hash;
+      int value;
+      bool used;
+   };
+
+   Slot *slots;                  /* The array of capacity slots        */
+   int capacity;                 /* Always a power of two              */
+   int count;                    /* The number of used slots           */
+
+   static unsigned long long hashKey(std::string_view key);
+   int findSlot(std::string_view key, unsigned long long hash) const;
+   void expand();
+
+/* Tables are not copied */
+
+   SymbolTable(const SymbolTable & src);
+   SymbolTable & operator=(const SymbolTable & src);
+
+};
+
+#endif
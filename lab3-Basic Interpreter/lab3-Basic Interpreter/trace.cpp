@@ -0,0 +1,107 @@
+/*
+ * File: trace.cpp
+ * ---------------
+ * This file implements the ExecutionTrace class.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "readfile.h"
+#include "trace.h"
+
+#include "../StanfordCPPLib/error.h"
+using namespace std;
+
+/*
+ * Implementation notes: trace file layout
+ * ---------------------------------------
+ * A trace file holds native-endian binary data in this order:
+ *
+ *    "BTR\0" outputHash(8 bytes) outputCount(8 bytes) inputCount(4 bytes)
+ *    inputCount 32-bit input values
+ *
+ * The output hash is FNV-1a over the bytes of each printed int.
+ */
+
+static const char TRACE_MAGIC[4] = { 'B', 'T', 'R', '\0' };
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+ExecutionTrace::ExecutionTrace() {
+   outputHash = FNV_OFFSET;
+   outputCount = 0;
+   expectedHash = FNV_OFFSET;
+   expectedCount = 0;
+}
+
+void ExecutionTrace::recordInput(int value) {
+   inputs.push_back(value);
+}
+
+void ExecutionTrace::recordOutput(int value) {
+   const unsigned char *bytes = (const unsigned char *) &value;
+   for (size_t i = 0; i < sizeof value; i++) {
+      outputHash ^= bytes[i];
+      outputHash *= FNV_PRIME;
+   }
+   outputCount++;
+}
+
+void ExecutionTrace::save(const string & filename) const {
+   string image(TRACE_MAGIC, sizeof TRACE_MAGIC);
+   image.append((const char *) &outputHash, sizeof outputHash);
+   image.append((const char *) &outputCount, sizeof outputCount);
+   int count = int(inputs.size());
+   image.append((const char *) &count, sizeof count);
+   if (count > 0) image.append((const char *) &inputs[0], count * sizeof(int));
+   ofstream out(filename.c_str(), ios::binary | ios::trunc);
+   out.write(image.data(), image.length());
+   out.close();
+   if (out.fail()) error("can't write trace " + filename);
+}
+
+/*
+ * Implementation notes: load
+ * --------------------------
+ * The file is read into memory by readWholeFile, which also accepts a
+ * pipe, and then decoded from memory.
+ */
+
+void ExecutionTrace::load(const string & filename) {
+   ifstream infile(filename.c_str(), ios::binary);
+   if (infile.fail()) error("can't open trace " + filename);
+   string image;
+   if (!readWholeFile(infile, image)) error("can't read trace " + filename);
+   size_t header = sizeof TRACE_MAGIC + sizeof expectedHash
+                 + sizeof expectedCount + sizeof(int);
+   if (image.length() < header
+       || memcmp(image.data(), TRACE_MAGIC, sizeof TRACE_MAGIC) != 0) {
+      error(filename + " is not a trace file");
+   }
+   const char *cp = image.data() + sizeof TRACE_MAGIC;
+   memcpy(&expectedHash, cp, sizeof expectedHash);
+   cp += sizeof expectedHash;
+   memcpy(&expectedCount, cp, sizeof expectedCount);
+   cp += sizeof expectedCount;
+   int count;
+   memcpy(&count, cp, sizeof count);
+   cp += sizeof count;
+   if (count < 0 || image.length() - header != count * sizeof(int)) {
+      error(filename + " is truncated");
+   }
+   expectedInputs.resize(count);
+   if (count > 0) memcpy(&expectedInputs[0], cp, count * sizeof(int));
+   inputs.clear();
+   outputHash = FNV_OFFSET;
+   outputCount = 0;
+}
+
+const vector<int> & ExecutionTrace::getExpectedInputs() const {
+   return expectedInputs;
+}
+
+bool ExecutionTrace::matchesExpectedOutput() const {
+   return outputHash == expectedHash && outputCount == expectedCount;
+}
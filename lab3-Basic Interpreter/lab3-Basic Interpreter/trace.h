@@ -0,0 +1,103 @@
+/*
+ * File: trace.h
+ * -------------
+ * This interface exports the ExecutionTrace class, which records the
+ * values a session reads with INPUT and a hash of the values it prints,
+ * so that the session can later be replayed and checked.
+ */
+
+#ifndef _trace_h
+#define _trace_h
+
+#include <string>
+#include <vector>
+
+/*
+ * Class: ExecutionTrace
+ * ---------------------
+ * While a session runs, INPUT reports every value it assigns with
+ * recordInput and PRINT reports every value it prints with recordOutput.
+ * The trace keeps the inputs and a running 64-bit FNV-1a hash of the
+ * outputs.  A trace saved with --record can be loaded with --replay;
+ * the session then takes its inputs from the trace and, when it ends,
+ * compares the hash of what it printed with the recorded one.
+ */
+
+class ExecutionTrace {
+
+public:
+
+/*
+ * Constructor: ExecutionTrace
+ * Usage: ExecutionTrace trace;
+ * ----------------------------
+ * Creates an empty trace.
+ */
+
+   ExecutionTrace();
+
+/*
+ * Methods: recordInput, recordOutput
+ * Usage: trace.recordInput(value);
+ *        trace.recordOutput(value);
+ * ---------------------------------
+ * Adds a value read by INPUT or printed by PRINT to the trace.
+ */
+
+   void recordInput(int value);
+   void recordOutput(int value);
+
+/*
+ * Method: save
+ * Usage: trace.save(filename);
+ * ----------------------------
+ * Writes the recorded inputs and the output hash and count to the named
+ * file.  If the file cannot be written, this method calls error.
+ */
+
+   void save(const std::string & filename) const;
+
+/*
+ * Method: load
+ * Usage: trace.load(filename);
+ * ----------------------------
+ * Reads a trace written by save.  The inputs it contains are returned
+ * by getExpectedInputs, and its output hash and count become the values
+ * that matchesExpectedOutput checks against.  The recorded state of this
+ * trace is reset.  If the file is unreadable or malformed, this method
+ * calls error.
+ */
+
+   void load(const std::string & filename);
+
+/*
+ * Method: getExpectedInputs
+ * Usage: const vector<int> & inputs = trace.getExpectedInputs();
+ * --------------------------------------------------------------
+ * Returns the inputs read by load.
+ */
+
+   const std::vector<int> & getExpectedInputs() const;
+
+/*
+ * Method: matchesExpectedOutput
+ * Usage: if (trace.matchesExpectedOutput()) ...
+ * ---------------------------------------------
+ * Returns true if the values printed since load hash to the same value,
+ * and are as many, as those of the loaded trace.
+ */
+
+   bool matchesExpectedOutput() const;
+
+private:
+
+   std::vector<int> inputs;                 /* Values read by INPUT      */
+   unsigned long long outputHash;           /* Hash of printed values    */
+   long long outputCount;                   /* Number of printed values  */
+   std::vector<int> expectedInputs;         /* Inputs read by load       */
+   unsigned long long expectedHash;         /* Output hash read by load  */
+   long long expectedCount;                 /* Output count read by load */
+
+};
+
+#endif